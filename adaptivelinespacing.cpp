@@ -0,0 +1,187 @@
+#include "adaptivelinespacing.h"
+#include <QtMath>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    const double earthRadius = 6371000.0;
+    const int binCount = 256;
+}
+
+AdaptiveLineSpacing::AdaptiveLineSpacing():m_active(false),m_started(false),m_side(1.0),m_length(0.0),m_overlap(0.1),m_latScale(0.0),m_lonScale(0.0),m_sentOffset(0.0)
+{
+}
+
+void AdaptiveLineSpacing::setLine(QGeoCoordinate const &start, QGeoCoordinate const &end, bool starboard)
+{
+    m_start = start;
+    m_end = end;
+    m_side = starboard ? 1.0 : -1.0;
+    m_latScale = earthRadius*M_PI/180.0;
+    m_lonScale = m_latScale*qCos(qDegreesToRadians(start.latitude()));
+
+    QPointF endPosition((end.longitude()-start.longitude())*m_lonScale,(end.latitude()-start.latitude())*m_latScale);
+    m_length = qSqrt(endPosition.x()*endPosition.x()+endPosition.y()*endPosition.y());
+    m_active = m_length > 0.0;
+    if(!m_active)
+        return;
+    m_along = endPosition/m_length;
+    m_across = QPointF(m_along.y(),-m_along.x())*m_side;
+
+    m_started = false;
+    m_sentOffset = 0.0;
+    m_edge.assign(binCount,std::numeric_limits<double>::lowest());
+}
+
+bool AdaptiveLineSpacing::active() const
+{
+    return m_active;
+}
+
+void AdaptiveLineSpacing::stop()
+{
+    m_active = false;
+    m_edge.clear();
+    m_rings.clear();
+}
+
+double AdaptiveLineSpacing::overlap() const
+{
+    return m_overlap;
+}
+
+void AdaptiveLineSpacing::setOverlap(double overlap)
+{
+    m_overlap = std::max(0.0,std::min(overlap,0.9));
+}
+
+QPointF AdaptiveLineSpacing::toLine(QGeoCoordinate const &location) const
+{
+    QPointF p((location.longitude()-m_start.longitude())*m_lonScale,(location.latitude()-m_start.latitude())*m_latScale);
+    return QPointF(p.x()*m_along.x()+p.y()*m_along.y(),p.x()*m_across.x()+p.y()*m_across.y());
+}
+
+QGeoCoordinate AdaptiveLineSpacing::fromLine(QPointF const &point) const
+{
+    QPointF p = m_along*point.x()+m_across*point.y();
+    return QGeoCoordinate(m_start.latitude()+p.y()/m_latScale,m_start.longitude()+p.x()/m_lonScale);
+}
+
+void AdaptiveLineSpacing::addEdge(QPointF const &a, QPointF const &b)
+{
+    double binSize = m_length/binCount;
+    double umin = std::min(a.x(),b.x());
+    double umax = std::max(a.x(),b.x());
+    if((a.y() <= 0.0 && b.y() <= 0.0) || umax < 0.0 || umin > m_length)
+        return;
+    int first = std::max(0,int(umin/binSize));
+    int last = std::min(binCount-1,int(umax/binSize));
+    for(int i = first; i <= last; i++)
+    {
+        // highest point of the edge within the bin
+        double u0 = std::max(umin,i*binSize);
+        double u1 = std::min(umax,(i+1)*binSize);
+        double v = std::max(a.y(),b.y());
+        if(umax > umin)
+        {
+            double v0 = a.y()+(b.y()-a.y())*(u0-a.x())/(b.x()-a.x());
+            double v1 = a.y()+(b.y()-a.y())*(u1-a.x())/(b.x()-a.x());
+            v = std::max(v0,v1);
+        }
+        m_edge[i] = std::max(m_edge[i],v);
+    }
+}
+
+bool AdaptiveLineSpacing::updateCoverage(bool reset, int firstRing, QList<QList<QGeoCoordinate> > const &coverage)
+{
+    if(!m_active)
+        return false;
+
+    if(reset)
+    {
+        m_rings.clear();
+        m_edge.assign(binCount,std::numeric_limits<double>::lowest());
+    }
+    if(firstRing+coverage.size() > int(m_rings.size()))
+    {
+        RingState empty;
+        empty.size = 0;
+        m_rings.resize(firstRing+coverage.size(),empty);
+    }
+    for(int i = 0; i < coverage.size(); i++)
+    {
+        if(coverage[i].empty())
+            continue;
+        RingState &ring = m_rings[firstRing+i];
+        QPointF a = toLine(ring.size ? ring.last : coverage[i].front());
+        for(auto const &location: coverage[i])
+        {
+            QPointF b = toLine(location);
+            addEdge(a,b);
+            a = b;
+        }
+        // The edge closing the ring is left out. Until the ring is complete it
+        // is a chord that may cut outside the coverage, and once complete it
+        // runs across the swath between vertices already binned.
+        ring.size += coverage[i].size();
+        ring.last = coverage[i].back();
+    }
+
+    double offset = nextOffset();
+    if(offset > 0.0 && qAbs(offset-m_sentOffset) > std::max(1.0,0.02*offset))
+    {
+        m_sentOffset = offset;
+        return true;
+    }
+    return false;
+}
+
+bool AdaptiveLineSpacing::updateLocation(QGeoCoordinate const &location)
+{
+    if(!m_active)
+        return false;
+    QPointF p = toLine(location);
+    if(p.x() > 0.0)
+        m_started = true;
+    double offset = nextOffset();
+    if(m_started && p.x() > m_length && offset > 0.0)
+    {
+        // Lines alternate direction so the side of the following line flips.
+        QGeoCoordinate start = fromLine(QPointF(m_length,offset));
+        QGeoCoordinate end = fromLine(QPointF(0.0,offset));
+        setLine(start,end,m_side < 0.0);
+        return true;
+    }
+    return false;
+}
+
+double AdaptiveLineSpacing::nextOffset() const
+{
+    // The narrowest half swath seen so far sets the spacing so the overlap holds
+    // along the whole line, assuming the next line sees a similar swath.
+    double edge = std::numeric_limits<double>::max();
+    for(double e: m_edge)
+        if(e > 0.0)
+            edge = std::min(edge,e);
+    if(edge == std::numeric_limits<double>::max())
+        return 0.0;
+    return 2.0*edge*(1.0-m_overlap);
+}
+
+QList<QGeoCoordinate> AdaptiveLineSpacing::waypoints() const
+{
+    QList<QGeoCoordinate> ret;
+    if(!m_active)
+        return ret;
+    if(!m_started)
+        ret.append(m_start);
+    ret.append(m_end);
+    double offset = nextOffset();
+    if(offset > 0.0)
+    {
+        ret.append(fromLine(QPointF(m_length,offset)));
+        ret.append(fromLine(QPointF(0.0,offset)));
+    }
+    return ret;
+}
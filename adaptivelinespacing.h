@@ -0,0 +1,76 @@
+#ifndef ADAPTIVELINESPACING_H
+#define ADAPTIVELINESPACING_H
+
+#include <QGeoCoordinate>
+#include <QList>
+#include <QPointF>
+#include <vector>
+
+/// Places the next survey line from the swath edge reported while running the
+/// current one. The outer edge of coverage on the next line's side is kept as a
+/// profile of bins along the current line and raised as coverage comes in, so
+/// each update only bins the polygon edges added since the last one.
+class AdaptiveLineSpacing
+{
+public:
+    AdaptiveLineSpacing();
+
+    /// Starts a new current line with the next one to be placed to starboard
+    /// (or port) of it, and clears the swath edge profile.
+    void setLine(QGeoCoordinate const &start, QGeoCoordinate const &end, bool starboard);
+    bool active() const;
+    void stop();
+
+    /// Fraction of the swath width shared by adjacent lines.
+    double overlap() const;
+    void setOverlap(double overlap);
+
+    /// Updates the edge profile with the vertices appended to the rings from
+    /// firstRing on, after clearing all coverage if reset is set. Returns true
+    /// if the next line moved enough to be worth sending again.
+    bool updateCoverage(bool reset, int firstRing, QList<QList<QGeoCoordinate> > const &coverage);
+
+    /// Returns true once the vehicle has gone past the end of the current line,
+    /// at which point the next line becomes the current one.
+    bool updateLocation(QGeoCoordinate const &location);
+
+    /// Offset of the next line in meters, or 0 if no swath edge is known yet.
+    double nextOffset() const;
+
+    /// Waypoints for the rest of the current line followed by the next line, run
+    /// in the opposite direction.
+    QList<QGeoCoordinate> waypoints() const;
+
+private:
+    QPointF toLine(QGeoCoordinate const &location) const;
+    QGeoCoordinate fromLine(QPointF const &point) const;
+    /// Raises the bins under the part of edge ab on the next line's side.
+    void addEdge(QPointF const &a, QPointF const &b);
+
+    /// What is needed of a coverage ring to bin the edges it gains next.
+    struct RingState
+    {
+        int size;
+        QGeoCoordinate last;
+    };
+
+    bool m_active;
+    bool m_started;
+    QGeoCoordinate m_start;
+    QGeoCoordinate m_end;
+    double m_side;
+    double m_length;
+    double m_overlap;
+
+    // local frame: u along the line from its start, v toward the next line
+    QPointF m_along;
+    QPointF m_across;
+    double m_latScale;
+    double m_lonScale;
+
+    std::vector<double> m_edge;
+    std::vector<RingState> m_rings;
+    double m_sentOffset;
+};
+
+#endif // ADAPTIVELINESPACING_H
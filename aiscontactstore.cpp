@@ -0,0 +1,126 @@
+#include "aiscontactstore.h"
+#include <algorithm>
+#include <cstring>
+
+AISContactStore::AISContactStore(int maxVessels):m_maxVessels(std::max(1,maxVessels))
+{
+    m_slots.reserve(m_maxVessels);
+}
+
+void AISContactStore::add(const AISContactReport& report, const QPointF& local)
+{
+    int slot;
+    auto s = m_slots.find(report.mmsi);
+    if(s != m_slots.end())
+        slot = s->second;
+    else
+        slot = allocate(report.mmsi);
+
+    Vessel &v = m_pool[slot];
+    memcpy(v.name,report.name,sizeof(v.name));
+    v.name[sizeof(v.name)-1] = 0;
+    v.dimension_to_bow = report.dimension_to_bow;
+    v.dimension_to_port = report.dimension_to_port;
+    v.dimension_to_stbd = report.dimension_to_stbd;
+    v.dimension_to_stern = report.dimension_to_stern;
+
+    Position &p = v.positions[(v.first+v.count)%historySize];
+    p.timestamp = report.timestamp;
+    p.latitude = report.latitude;
+    p.longitude = report.longitude;
+    p.heading = report.heading;
+    p.local = local;
+    if(v.count < historySize)
+        v.count++;
+    else
+        v.first = (v.first+1)%historySize;
+}
+
+int AISContactStore::allocate(quint32 mmsi)
+{
+    if(int(m_active.size()) >= m_maxVessels)
+    {
+        int oldest = m_active.front();
+        for(int slot: m_active)
+            if(m_pool[slot].latest().timestamp < m_pool[oldest].latest().timestamp)
+                oldest = slot;
+        release(oldest);
+    }
+    int slot;
+    if(!m_free.empty())
+    {
+        slot = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        slot = m_pool.size();
+        m_pool.push_back(Vessel());
+    }
+    Vessel &v = m_pool[slot];
+    v.mmsi = mmsi;
+    v.first = 0;
+    v.count = 0;
+    v.activeIndex = m_active.size();
+    m_active.push_back(slot);
+    m_slots[mmsi] = slot;
+    return slot;
+}
+
+void AISContactStore::release(int slot)
+{
+    Vessel &v = m_pool[slot];
+    m_slots.erase(v.mmsi);
+    int last = m_active.back();
+    m_active[v.activeIndex] = last;
+    m_pool[last].activeIndex = v.activeIndex;
+    m_active.pop_back();
+    m_free.push_back(slot);
+}
+
+void AISContactStore::expire(double now, double maxAge)
+{
+    for(int i = m_active.size()-1; i >= 0; i--)
+    {
+        int slot = m_active[i];
+        Vessel &v = m_pool[slot];
+        while(v.count > 0 && now-v.position(0).timestamp > maxAge)
+        {
+            v.first = (v.first+1)%historySize;
+            v.count--;
+        }
+        if(v.count == 0)
+            release(slot);
+    }
+}
+
+void AISContactStore::reproject(std::function<QPointF(QGeoCoordinate const &)> const &project)
+{
+    for(int slot: m_active)
+    {
+        Vessel &v = m_pool[slot];
+        for(int i = 0; i < v.count; i++)
+        {
+            Position &p = v.positions[(v.first+i)%historySize];
+            p.local = project(QGeoCoordinate(p.latitude,p.longitude));
+        }
+    }
+}
+
+void AISContactStore::clear()
+{
+    m_pool.clear();
+    m_free.clear();
+    m_active.clear();
+    m_slots.clear();
+}
+
+int AISContactStore::vesselCount() const
+{
+    return m_active.size();
+}
+
+AISContactStore::Vessel const & AISContactStore::vessel(int i) const
+{
+    return m_pool[m_active[i]];
+}
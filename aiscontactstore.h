@@ -0,0 +1,92 @@
+#ifndef AISCONTACTSTORE_H
+#define AISCONTACTSTORE_H
+
+#include <QGeoCoordinate>
+#include <QMetaType>
+#include <QPointF>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+/// One AIS position report, copied by value from the ROS thread.
+struct AISContactReport
+{
+    double timestamp; // seconds
+    quint32 mmsi;
+    char name[21];
+    double latitude;
+    double longitude;
+    float heading; // degrees
+    float dimension_to_bow;
+    float dimension_to_port;
+    float dimension_to_stbd;
+    float dimension_to_stern;
+};
+
+Q_DECLARE_METATYPE(AISContactReport)
+
+/// Recent AIS reports for many vessels in flat memory. Each vessel owns a
+/// fixed ring of its latest positions inside one pooled slot; slots of
+/// vessels that go quiet are expired and reused, and when all slots are
+/// taken the vessel heard from longest ago gives up its slot.
+class AISContactStore
+{
+public:
+    static const int historySize = 32;
+
+    struct Position
+    {
+        double timestamp;
+        double latitude;
+        double longitude;
+        float heading;
+        QPointF local;
+    };
+
+    struct Vessel
+    {
+        quint32 mmsi;
+        char name[21];
+        float dimension_to_bow;
+        float dimension_to_port;
+        float dimension_to_stbd;
+        float dimension_to_stern;
+
+        int positionCount() const {return count;}
+        /// Position i counted from the oldest.
+        Position const &position(int i) const {return positions[(first+i)%historySize];}
+        Position const &latest() const {return position(count-1);}
+
+    private:
+        friend class AISContactStore;
+        Position positions[historySize];
+        int first;
+        int count;
+        int activeIndex;
+    };
+
+    explicit AISContactStore(int maxVessels = 8192);
+
+    /// Records a report with its projected position.
+    void add(AISContactReport const &report, QPointF const &local);
+    /// Drops positions older than maxAge seconds and vessels left with none.
+    void expire(double now, double maxAge);
+    void reproject(std::function<QPointF(QGeoCoordinate const &)> const &project);
+    void clear();
+
+    int vesselCount() const;
+    Vessel const &vessel(int i) const;
+
+private:
+    int m_maxVessels;
+    std::vector<Vessel> m_pool;
+    std::vector<int> m_free;
+    // slots in use, so walking the vessels skips free ones
+    std::vector<int> m_active;
+    std::unordered_map<quint32,int> m_slots;
+
+    int allocate(quint32 mmsi);
+    void release(int slot);
+};
+
+#endif // AISCONTACTSTORE_H
@@ -9,6 +9,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QSvgRenderer>
+#include "symbolatlas.h"
 #include <QMimeData>
 #include <QDebug>
 
@@ -21,6 +22,8 @@
 #include "group.h"
 #include <gdal_priv.h>
 #include "vectordataset.h"
+#include "vectorlayer.h"
+#include "hazardchecker.h"
 #include "behavior.h"
 
 #ifdef AMP_ROS
@@ -29,7 +32,7 @@
 
 #include <iostream>
 
-AutonomousVehicleProject::AutonomousVehicleProject(QObject *parent) : QAbstractItemModel(parent), m_currentBackground(nullptr), m_currentPlatform(nullptr), m_currentGroup(nullptr), m_currentSelected(nullptr), m_symbols(new QSvgRenderer(QString(":/symbols.svg"),this)), m_map_scale(1.0)
+AutonomousVehicleProject::AutonomousVehicleProject(QObject *parent) : QAbstractItemModel(parent), m_currentBackground(nullptr), m_currentPlatform(nullptr), m_currentGroup(nullptr), m_currentSelected(nullptr), m_symbols(new QSvgRenderer(QString(":/symbols.svg"),this)), m_symbolAtlas(new SymbolAtlas(m_symbols)), m_hazardChecker(new HazardChecker(this)), m_map_scale(1.0)
 {
     GDALAllRegister();
 
@@ -47,6 +50,7 @@ AutonomousVehicleProject::AutonomousVehicleProject(QObject *parent) : QAbstractI
 
 AutonomousVehicleProject::~AutonomousVehicleProject()
 {
+    delete m_symbolAtlas;
 }
 
 QGraphicsScene *AutonomousVehicleProject::scene() const
@@ -64,6 +68,11 @@ QSvgRenderer * AutonomousVehicleProject::symbols() const
     return m_symbols;
 }
 
+SymbolAtlas * AutonomousVehicleProject::symbolAtlas() const
+{
+    return m_symbolAtlas;
+}
+
 
 void AutonomousVehicleProject::save(const QString &fname)
 {
@@ -118,13 +127,17 @@ void AutonomousVehicleProject::openBackground(const QString &fname)
     }
 }
 
-void AutonomousVehicleProject::openGeometry(const QString& fname)
+VectorDataset * AutonomousVehicleProject::openGeometry(const QString& fname, QGeoRectangle const &area)
 {
-    RowInserter ri(*this,m_currentGroup);
-    VectorDataset * vd = new VectorDataset(m_currentGroup);
-    vd->setObjectName(fname);
-    vd->open(fname);
+    VectorDataset * vd = nullptr;
+    {
+        RowInserter ri(*this,m_currentGroup);
+        vd = new VectorDataset(m_currentGroup);
+        vd->setObjectName(fname);
+    }
+    vd->open(fname,area);
     connect(this,&AutonomousVehicleProject::backgroundUpdated,vd,&VectorDataset::updateProjectedPoints);
+    return vd;
 }
 
 void AutonomousVehicleProject::import(const QString& fname)
@@ -292,16 +305,13 @@ void AutonomousVehicleProject::exportHypack(const QModelIndex &index)
             {
                 QTextStream outstream(&outfile);
                 outstream << "LNS 1\n";
-                auto waypoints = tl->childItems();
+                // waypoints only, the line also carries its label and hazard highlight
+                auto waypoints = tl->waypoints();
                 outstream << "LIN " << waypoints.size() << "\n";
-                for(auto i: waypoints)
+                for(auto wp: waypoints)
                 {
-                    const Waypoint *wp = qgraphicsitem_cast<Waypoint const*>(i);
-                    if(wp)
-                    {
-                        auto ll = wp->location();
-                        outstream << "PTS " << ll.latitude() << " " << ll.longitude() << "\n";
-                    }
+                    auto ll = wp->location();
+                    outstream << "PTS " << ll.latitude() << " " << ll.longitude() << "\n";
                 }
                 outstream << "LNN 1\n";
                 outstream << "EOL\n";
@@ -439,6 +449,17 @@ void AutonomousVehicleProject::deleteItem(MissionItem *item)
     deleteItem(indexFromItem(item));
 }
 
+void AutonomousVehicleProject::reorderChildren(MissionItem* parent, const QList<MissionItem *>& order)
+{
+    QModelIndex parentIndex = indexFromItem(parent);
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>() << parentIndex);
+    parent->setChildMissionItemsOrder(order);
+    for(auto index: persistentIndexList())
+        if(index.parent() == parentIndex)
+            changePersistentIndex(index,createIndex(order.indexOf(itemFromIndex(index)),0,itemFromIndex(index)));
+    emit layoutChanged(QList<QPersistentModelIndex>() << parentIndex);
+}
+
 void AutonomousVehicleProject::setCurrent(const QModelIndex &index)
 {
     auto last_selected = m_currentSelected;
@@ -495,6 +516,38 @@ Platform * AutonomousVehicleProject::currentPlatform() const
     return m_currentPlatform;
 }
 
+QList<Platform *> AutonomousVehicleProject::platforms() const
+{
+    QList<Platform *> ret;
+    QList<MissionItem *> pending;
+    pending.append(m_root);
+    while(!pending.empty())
+    {
+        MissionItem *item = pending.takeFirst();
+        Platform *p = qobject_cast<Platform*>(item);
+        if(p)
+            ret.append(p);
+        pending.append(item->childMissionItems());
+    }
+    return ret;
+}
+
+QList<VectorLayer *> AutonomousVehicleProject::vectorLayers() const
+{
+    QList<VectorLayer *> ret;
+    QList<MissionItem *> pending;
+    pending.append(m_root);
+    while(!pending.empty())
+    {
+        MissionItem *item = pending.takeFirst();
+        VectorLayer *vl = qobject_cast<VectorLayer*>(item);
+        if(vl)
+            ret.append(vl);
+        pending.append(item->childMissionItems());
+    }
+    return ret;
+}
+
 QModelIndex AutonomousVehicleProject::index(int row, int column, const QModelIndex& parent) const
 {
     if(column != 0 || row < 0)
@@ -668,12 +721,13 @@ void AutonomousVehicleProject::updateMapScale(qreal scale)
     if(m_currentBackground)
         m_currentBackground->updateMapScale(scale);
     m_map_scale = scale;
+    emit mapScaleChanged(scale);
     
 }
 
-AutonomousVehicleProject::RowInserter::RowInserter(AutonomousVehicleProject& project, MissionItem* parent):m_project(project)
+AutonomousVehicleProject::RowInserter::RowInserter(AutonomousVehicleProject& project, MissionItem* parent, int count):m_project(project)
 {
-    project.beginInsertRows(project.indexFromItem(parent),parent->childMissionItems().size(),parent->childMissionItems().size());
+    project.beginInsertRows(project.indexFromItem(parent),parent->childMissionItems().size(),parent->childMissionItems().size()+count-1);
 }
 
 AutonomousVehicleProject::RowInserter::~RowInserter()
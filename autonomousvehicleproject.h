@@ -3,6 +3,7 @@
 
 #include <QAbstractItemModel>
 #include <QGeoCoordinate>
+#include <QGeoRectangle>
 #include <QModelIndex>
 
 
@@ -20,10 +21,14 @@ class SurveyArea;
 class Platform;
 class Group;
 class QSvgRenderer;
+class SymbolAtlas;
 #ifdef AMP_ROS
 class ROSLink;
 #endif
 class Behavior;
+class VectorDataset;
+class VectorLayer;
+class HazardChecker;
 
 class AutonomousVehicleProject : public QAbstractItemModel
 {
@@ -50,6 +55,8 @@ public:
 
     Platform * createPlatform();
     Platform * currentPlatform() const;
+    QList<Platform *> platforms() const;
+    QList<VectorLayer *> vectorLayers() const;
     
     Behavior * createBehavior();
     
@@ -79,7 +86,7 @@ public:
     void save(QString const &fname = QString());
     void open(QString const &fname);
     
-    void openGeometry(QString const &fname);
+    VectorDataset * openGeometry(QString const &fname, QGeoRectangle const &area = QGeoRectangle());
     
     void import(QString const &fname);
 
@@ -87,6 +94,7 @@ public:
     MissionItem *currentSelected() const;
     
     QSvgRenderer * symbols() const;
+    SymbolAtlas * symbolAtlas() const;
     
     
 #ifdef AMP_ROS
@@ -98,6 +106,7 @@ public:
 signals:
     void currentPlaformUpdated();
     void backgroundUpdated(BackgroundRaster *bg);
+    void mapScaleChanged(qreal scale);
 
 public slots:
 
@@ -107,6 +116,7 @@ public slots:
     void deleteItems(QModelIndexList const &indices);
     void deleteItem(QModelIndex const &index);
     void deleteItem(MissionItem *item);
+    void reorderChildren(MissionItem *parent, QList<MissionItem *> const &order);
     void updateMapScale(qreal scale);
 
 
@@ -123,6 +133,8 @@ private:
 #endif
     
     QSvgRenderer* m_symbols;
+    SymbolAtlas* m_symbolAtlas;
+    HazardChecker* m_hazardChecker;
     
 
     void setCurrentBackground(BackgroundRaster *bgr);
@@ -133,7 +145,7 @@ public:
     class RowInserter
     {
     public:
-        RowInserter(AutonomousVehicleProject &project, MissionItem *parent);
+        RowInserter(AutonomousVehicleProject &project, MissionItem *parent, int count = 1);
         
         ~RowInserter();
     private:
@@ -0,0 +1,113 @@
+#include "rtree.h"
+#include <QtTest>
+#include <random>
+
+namespace
+{
+    const int featureCount = 1000000;
+    const double extent = 100000.0;
+
+    // Feature boxes scattered over a 100 km square, up to 200 m across. A third
+    // of them are single points, with empty boxes.
+    std::vector<QRectF> features()
+    {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<double> position(0.0,extent);
+        std::uniform_real_distribution<double> size(0.0,200.0);
+        std::vector<QRectF> ret;
+        ret.reserve(featureCount);
+        for(int i = 0; i < featureCount; i++)
+        {
+            double x = position(random);
+            double y = position(random);
+            if(i%3 == 0)
+                ret.push_back(QRectF(x,y,0.0,0.0));
+            else
+                ret.push_back(QRectF(x,y,size(random),size(random)));
+        }
+        return ret;
+    }
+}
+
+class RTreeBenchmark: public QObject
+{
+    Q_OBJECT
+
+private:
+    std::vector<QRectF> m_boxes;
+    RTree m_tree;
+
+private slots:
+    void initTestCase()
+    {
+        m_boxes = features();
+        m_tree.build(m_boxes);
+    }
+
+    void build()
+    {
+        RTree tree;
+        QBENCHMARK
+        {
+            tree.build(m_boxes);
+        }
+        QCOMPARE(tree.size(), featureCount);
+    }
+
+    void viewport()
+    {
+        QRectF view(50000.0,50000.0,1000.0,1000.0);
+        std::vector<int> hits;
+        QBENCHMARK
+        {
+            hits = m_tree.query(view);
+        }
+        QVERIFY(!hits.empty());
+    }
+
+    // what the index replaces
+    void viewportLinearScan()
+    {
+        QRectF view(50000.0,50000.0,1000.0,1000.0);
+        std::vector<int> hits;
+        QBENCHMARK
+        {
+            hits.clear();
+            for(int i = 0; i < int(m_boxes.size()); i++)
+            {
+                QRectF const &b = m_boxes[i];
+                if(b.left() <= view.right() && view.left() <= b.right() && b.top() <= view.bottom() && view.top() <= b.bottom())
+                    hits.push_back(i);
+            }
+        }
+        QVERIFY(!hits.empty());
+    }
+
+    void line()
+    {
+        QPolygonF track;
+        track << QPointF(10000.0,10000.0) << QPointF(30000.0,12000.0) << QPointF(32000.0,30000.0);
+        std::vector<int> hits;
+        QBENCHMARK
+        {
+            hits = m_tree.queryLine(track);
+        }
+        QVERIFY(!hits.empty());
+    }
+
+    void polygon()
+    {
+        QPolygonF triangle;
+        triangle << QPointF(60000.0,60000.0) << QPointF(64000.0,60000.0) << QPointF(62000.0,63000.0) << QPointF(60000.0,60000.0);
+        std::vector<int> hits;
+        QBENCHMARK
+        {
+            hits = m_tree.queryPolygon(triangle);
+        }
+        QVERIFY(!hits.empty());
+    }
+};
+
+QTEST_APPLESS_MAIN(RTreeBenchmark)
+
+#include "rtreebenchmark.moc"
@@ -0,0 +1,78 @@
+#include "surveylinegenerator.h"
+#include <QtMath>
+#include <QtTest>
+#include <random>
+
+namespace
+{
+    const QGeoCoordinate center(43.07,-70.71);
+
+    // A ring of vertices points about center, its radius wandering with the
+    // sum of many random sines so the shore is ragged and deeply concave.
+    QList<QGeoCoordinate> ring(int points, double radius, double roughness, QPointF const &offset, std::mt19937 &random)
+    {
+        std::uniform_real_distribution<double> phase(0.0,2*M_PI);
+        std::vector<double> phases;
+        for(int f = 0; f < 64; f++)
+            phases.push_back(phase(random));
+
+        QList<QGeoCoordinate> ret;
+        for(int i = 0; i < points; i++)
+        {
+            double a = 2*M_PI*i/points;
+            double r = 1.0;
+            for(int f = 0; f < int(phases.size()); f++)
+                r += roughness*qSin((f+2)*a+phases[f])/(f+2);
+            double x = offset.x()+radius*r*qCos(a);
+            double y = offset.y()+radius*r*qSin(a);
+            ret.append(center.atDistanceAndAzimuth(qSqrt(x*x+y*y),qRadiansToDegrees(qAtan2(x,y))));
+        }
+        return ret;
+    }
+
+    // A coastline of about vertices points around a bay 5 km across, with islands.
+    QList<QList<QGeoCoordinate> > coastline(int vertices)
+    {
+        std::mt19937 random(vertices);
+        QList<QList<QGeoCoordinate> > ret;
+        ret.append(ring(vertices*3/4,5000.0,0.25,QPointF(),random));
+        std::uniform_real_distribution<double> position(-1500.0,1500.0);
+        int islands = 20;
+        for(int i = 0; i < islands; i++)
+            ret.append(ring(vertices/4/islands,150.0,0.25,QPointF(position(random),position(random)),random));
+        return ret;
+    }
+}
+
+class SurveyLineGeneratorBenchmark: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void generate_data()
+    {
+        QTest::addColumn<int>("vertices");
+        QTest::addColumn<double>("direction");
+        QTest::newRow("1k vertices") << 1000 << 37.0;
+        QTest::newRow("20k vertices") << 20000 << 37.0;
+        QTest::newRow("100k vertices") << 100000 << 37.0;
+        QTest::newRow("100k vertices, north") << 100000 << 0.0;
+    }
+
+    void generate()
+    {
+        QFETCH(int, vertices);
+        QFETCH(double, direction);
+        SurveyLineGenerator generator(coastline(vertices));
+        QList<QLineF> lines;
+        QBENCHMARK
+        {
+            lines = generator.generateLocal(direction,10.0);
+        }
+        QVERIFY(!lines.empty());
+    }
+};
+
+QTEST_APPLESS_MAIN(SurveyLineGeneratorBenchmark)
+
+#include "surveylinegeneratorbenchmark.moc"
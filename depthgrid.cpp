@@ -0,0 +1,193 @@
+#include "depthgrid.h"
+#include <QColor>
+#include <QMutexLocker>
+#include <QtMath>
+#include <limits>
+
+namespace
+{
+    const int colorCount = 1024;
+
+    quint64 tileKey(int level, int column, int row)
+    {
+        return (quint64(level) << 56) | (quint64(quint32(column) & 0xfffffff) << 28) | quint64(quint32(row) & 0xfffffff);
+    }
+}
+
+DepthGrid::DepthGrid(double cellSize, int levelCount, int maxTiles):m_cellSize(cellSize),m_levelCount(levelCount),m_maxTiles(maxTiles),m_batch(0)
+{
+    qRegisterMetaType<QVector<Sounding> >();
+    m_shallow = std::numeric_limits<float>::max();
+    m_deep = -m_shallow;
+    // shallow red through to deep blue
+    m_colors.resize(colorCount);
+    for(int i = 0; i < colorCount; i++)
+        m_colors[i] = QColor::fromHsvF(0.66*i/(colorCount-1),1.0,1.0).rgb();
+}
+
+int DepthGrid::levelCount() const
+{
+    return m_levelCount;
+}
+
+double DepthGrid::cellSize(int level) const
+{
+    return m_cellSize*(1 << level);
+}
+
+int DepthGrid::levelFor(double size) const
+{
+    int level = 0;
+    while(level < m_levelCount-1 && cellSize(level) < size)
+        level++;
+    return level;
+}
+
+QList<DepthGrid::TileImage> DepthGrid::tiles(int level) const
+{
+    QList<TileImage> ret;
+    QMutexLocker lock(&m_imagesMutex);
+    for(auto i = m_images.begin(); i != m_images.end(); i++)
+        if(int(i.key() >> 56) == level)
+            ret.append(i.value());
+    return ret;
+}
+
+void DepthGrid::addSoundings(const QVector<Sounding>& soundings)
+{
+    m_batch++;
+    bool rampChanged = false;
+    for(auto const &s: soundings)
+    {
+        if(qIsNaN(s.x) || qIsNaN(s.y) || qIsNaN(s.depth))
+            continue;
+        if(s.depth < m_shallow || s.depth > m_deep)
+        {
+            // widen by a quarter of the span so the ramp rarely moves
+            float shallow = qMin(m_shallow,s.depth);
+            float deep = qMax(m_deep,s.depth);
+            float pad = qMax(1.0f,(deep-shallow)/4.0f);
+            m_shallow = s.depth < m_shallow ? shallow-pad : shallow;
+            m_deep = s.depth > m_deep ? deep+pad : deep;
+            rampChanged = true;
+        }
+        for(int level = 0; level < m_levelCount; level++)
+        {
+            double size = cellSize(level);
+            qint64 cx = qFloor(s.x/size);
+            qint64 cy = qFloor(s.y/size);
+            int column = int(qFloor(double(cx)/tileSize));
+            int row = int(qFloor(double(cy)/tileSize));
+            Tile &t = tile(level,column,row);
+            // image rows run north to south
+            int x = int(cx-qint64(column)*tileSize);
+            int y = int(tileSize-1-(cy-qint64(row)*tileSize));
+            int i = y*tileSize+x;
+            if(t.count[i] < std::numeric_limits<quint16>::max())
+            {
+                t.sum[i] += s.depth;
+                t.count[i]++;
+            }
+            t.used = m_batch;
+            t.dirty |= QRect(x,y,1,1);
+        }
+    }
+
+    // Only the changed cells are colored again, unless the ramp moved and
+    // every cell's color with it.
+    QHash<quint64, TileImage> rendered;
+    for(auto &kv: m_tiles)
+    {
+        Tile &t = kv.second;
+        if(rampChanged)
+            t.dirty = QRect(0,0,tileSize,tileSize);
+        if(t.dirty.isNull())
+            continue;
+        render(t,t.dirty);
+        t.dirty = QRect();
+        double size = cellSize(t.level)*tileSize;
+        TileImage ti;
+        ti.extent = QRectF(t.column*size,t.row*size,size,size);
+        ti.image = t.image;
+        rendered[kv.first] = ti;
+    }
+    evict();
+    {
+        QMutexLocker lock(&m_imagesMutex);
+        for(auto i = rendered.begin(); i != rendered.end(); i++)
+            if(m_tiles.count(i.key()))
+                m_images[i.key()] = i.value();
+    }
+    if(!rendered.isEmpty())
+        emit updated();
+}
+
+void DepthGrid::clear()
+{
+    m_tiles.clear();
+    m_shallow = std::numeric_limits<float>::max();
+    m_deep = -m_shallow;
+    {
+        QMutexLocker lock(&m_imagesMutex);
+        m_images.clear();
+    }
+    emit updated();
+}
+
+DepthGrid::Tile & DepthGrid::tile(int level, int column, int row)
+{
+    quint64 key = tileKey(level,column,row);
+    auto t = m_tiles.find(key);
+    if(t != m_tiles.end())
+        return t->second;
+    Tile &ret = m_tiles[key];
+    ret.level = level;
+    ret.column = column;
+    ret.row = row;
+    ret.sum.assign(tileSize*tileSize,0.0f);
+    ret.count.assign(tileSize*tileSize,0);
+    ret.used = m_batch;
+    ret.image = QImage(tileSize,tileSize,QImage::Format_ARGB32_Premultiplied);
+    ret.image.fill(Qt::transparent);
+    return ret;
+}
+
+void DepthGrid::evict()
+{
+    std::vector<quint64> evicted;
+    while(int(m_tiles.size()) > m_maxTiles)
+    {
+        auto oldest = m_tiles.begin();
+        for(auto t = m_tiles.begin(); t != m_tiles.end(); t++)
+            if(t->second.used < oldest->second.used || (t->second.used == oldest->second.used && t->second.level < oldest->second.level))
+                oldest = t;
+        evicted.push_back(oldest->first);
+        m_tiles.erase(oldest);
+    }
+    if(evicted.empty())
+        return;
+    QMutexLocker lock(&m_imagesMutex);
+    for(auto key: evicted)
+        m_images.remove(key);
+}
+
+void DepthGrid::render(DepthGrid::Tile& t, QRect const &area) const
+{
+    // writing detaches the image from the copy last handed out, which the
+    // GUI thread may still be drawing
+    float span = qMax(m_deep-m_shallow,1e-3f);
+    float scale = (colorCount-1)/span;
+    for(int y = area.top(); y <= area.bottom(); y++)
+    {
+        QRgb *line = reinterpret_cast<QRgb*>(t.image.scanLine(y));
+        for(int x = area.left(); x <= area.right(); x++)
+        {
+            int i = y*tileSize+x;
+            if(!t.count[i])
+                continue;
+            float depth = t.sum[i]/t.count[i];
+            int c = int((depth-m_shallow)*scale+0.5f);
+            line[x] = m_colors[qBound(0,c,colorCount-1)];
+        }
+    }
+}
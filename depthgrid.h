@@ -0,0 +1,104 @@
+#ifndef DEPTHGRID_H
+#define DEPTHGRID_H
+
+#include <QObject>
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QRect>
+#include <QRectF>
+#include <QVector>
+#include <unordered_map>
+#include <vector>
+
+/// A multibeam sounding in the ROS map frame: meters east and north of the
+/// origin, depth positive down.
+struct Sounding
+{
+    float x;
+    float y;
+    float depth;
+};
+
+Q_DECLARE_METATYPE(Sounding)
+
+/// Bins soundings into mean depth grids, one per level, each level's cells
+/// twice the size of the previous one's. Grids are split into square tiles
+/// created as soundings reach them, and the cells that change are colored
+/// from a precomputed ramp into each tile's image. Once maxTiles exist, the
+/// tile updated longest ago makes room, so memory stays bounded however long
+/// the survey runs; coarse tiles are updated by every nearby ping and so
+/// outlast the fine ones.
+///
+/// Binning and rendering run on the thread the grid lives on. The rendered
+/// tiles may be read from any thread.
+class DepthGrid : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int tileSize = 128;
+
+    struct TileImage
+    {
+        /// Map frame meters. The image's top row lies along the north edge,
+        /// where y is extent.bottom().
+        QRectF extent;
+        QImage image;
+    };
+
+    explicit DepthGrid(double cellSize = 1.0, int levelCount = 8, int maxTiles = 256);
+
+    int levelCount() const;
+    double cellSize(int level) const;
+    /// The finest level whose cells are at least size meters.
+    int levelFor(double size) const;
+
+    QList<TileImage> tiles(int level) const;
+
+public slots:
+    void addSoundings(QVector<Sounding> const &soundings);
+    void clear();
+
+signals:
+    /// Rendered tiles changed.
+    void updated();
+
+private:
+    struct Tile
+    {
+        int level;
+        int column;
+        int row;
+        std::vector<float> sum;
+        std::vector<quint16> count;
+        quint64 used;
+        /// Cells changed since the image was last brought up to date.
+        QRect dirty;
+        QImage image;
+    };
+
+    double m_cellSize;
+    int m_levelCount;
+    int m_maxTiles;
+    std::unordered_map<quint64, Tile> m_tiles;
+    quint64 m_batch;
+    // depths spanned by the color ramp, widened ahead of the data
+    float m_shallow;
+    float m_deep;
+    // the color ramp, shallow to deep
+    std::vector<QRgb> m_colors;
+
+    mutable QMutex m_imagesMutex;
+    QHash<quint64, TileImage> m_images;
+
+    Tile &tile(int level, int column, int row);
+    void evict();
+    /// Colors the cells of area in the tile's image.
+    void render(Tile &t, QRect const &area) const;
+};
+
+#endif // DEPTHGRID_H
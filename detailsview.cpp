@@ -9,6 +9,8 @@
 #include "tracklinedetails.h"
 #include "surveypattern.h"
 #include "surveypatterndetails.h"
+#include "surveyarea.h"
+#include "surveyareadetails.h"
 #include "platform.h"
 #include "platformdetails.h"
 #include "behavior.h"
@@ -26,6 +28,8 @@ DetailsView::DetailsView(QWidget *parent) : QWidget(parent), m_project(nullptr),
     trackLineDetails->hide();
     surveyPatternDetails = new SurveyPatternDetails(this);
     surveyPatternDetails->hide();
+    surveyAreaDetails = new SurveyAreaDetails(this);
+    surveyAreaDetails->hide();
     platformDetails = new PlatformDetails(this);
     platformDetails->hide();
     behaviorDetails = new BehaviorDetails(this);
@@ -89,6 +93,12 @@ void DetailsView::onCurrentItemChanged(const QModelIndex &current, const QModelI
         setCurrentWidget(surveyPatternDetails);
         surveyPatternDetails->setSurveyPattern(sp);
     }
+    else if (itemType == "SurveyArea")
+    {
+        SurveyArea *sa = qobject_cast<SurveyArea*>(mi);
+        setCurrentWidget(surveyAreaDetails);
+        surveyAreaDetails->setSurveyArea(sa);
+    }
     else if (itemType == "Platform")
     {
         Platform *p = qobject_cast<Platform*>(mi);
@@ -8,6 +8,7 @@ class BackgroundDetails;
 class WaypointDetails;
 class TrackLineDetails;
 class SurveyPatternDetails;
+class SurveyAreaDetails;
 class PlatformDetails;
 class ROSDetails;
 class BehaviorDetails;
@@ -36,6 +37,7 @@ private:
     WaypointDetails * waypointDetails;
     TrackLineDetails * trackLineDetails;
     SurveyPatternDetails * surveyPatternDetails;
+    SurveyAreaDetails * surveyAreaDetails;
     PlatformDetails * platformDetails;
     ROSDetails * rosDetails;
     BehaviorDetails * behaviorDetails;
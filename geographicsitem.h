@@ -21,7 +21,9 @@ public:
             PolygonType,
             ROSLinkType,
             SurveyAreaType,
-            MeasuringToolType
+            MeasuringToolType,
+            VectorLayerType,
+            HazardHighlightType
     };
     
     GeoGraphicsItem(QGraphicsItem *parentItem = Q_NULLPTR);
@@ -3,6 +3,8 @@
 #include<QJsonObject>
 #include<QJsonArray>
 #include"autonomousvehicleproject.h"
+#include"lineorderoptimizer.h"
+#include"trackline.h"
 
 Group::Group(MissionItem* parent):MissionItem(parent)
 {
@@ -47,3 +49,41 @@ bool Group::canAcceptChildType(const std::string& childType) const
 {
     return true;
 }
+
+void Group::optimizeLineOrder(int timeBudget)
+{
+    LineOrderOptimizer optimizer;
+    QList<int> lineChildren;
+    QList<LineOrderOptimizer::Step> initial;
+    auto children = childMissionItems();
+    for(int i = 0; i < children.size(); i++)
+    {
+        auto lines = children[i]->getLines();
+        if(lines.empty() || lines.front().empty() || lines.back().empty())
+            continue;
+        // Reversing a survey pattern swaps its start and end corners, which
+        // does not trade its entry for its exit, so patterns keep their direction.
+        bool reversible = qobject_cast<TrackLine*>(children[i]);
+        optimizer.addLine(lines.front().front(),lines.back().back(),reversible);
+        LineOrderOptimizer::Step s = {lineChildren.size(),false};
+        initial.append(s);
+        lineChildren.append(i);
+    }
+    if(lineChildren.size() < 2)
+        return;
+
+    auto order = optimizer.optimize(initial,timeBudget);
+    QList<MissionItem *> reordered = children;
+    for(int i = 0; i < order.size(); i++)
+    {
+        MissionItem *item = children[lineChildren[order[i].index]];
+        reordered[lineChildren[i]] = item;
+        if(order[i].reversed)
+        {
+            TrackLine *tl = qobject_cast<TrackLine*>(item);
+            if(tl)
+                tl->reverseDirection();
+        }
+    }
+    autonomousVehicleProject()->reorderChildren(this,reordered);
+}
@@ -16,6 +16,11 @@ public:
     
     bool canAcceptChildType(const std::string & childType) const override;
     
+    /// Reorders children with lines to minimize transit between them, reversing
+    /// track lines where that helps. Survey patterns keep their direction and
+    /// other children keep their places.
+    void optimizeLineOrder(int timeBudget = 500);
+    
 public slots:
     void updateProjectedPoints() override;
 };
@@ -0,0 +1,328 @@
+#include "hazardchecker.h"
+#include <QPainter>
+#include <QThread>
+#include "autonomousvehicleproject.h"
+#include "backgroundraster.h"
+#include "geographicsmissionitem.h"
+#include "surveypattern.h"
+#include "trackline.h"
+#include "vectordataset.h"
+#include "vectorlayer.h"
+
+/// Marks the hazardous segments and crossings of one plan item.
+class HazardHighlight : public GeoGraphicsItem
+{
+public:
+    HazardHighlight(AutonomousVehicleProject *project, QGraphicsItem *parentItem):GeoGraphicsItem(parentItem),m_project(project)
+    {
+    }
+
+    QRectF boundingRect() const override
+    {
+        // room for the cosmetic markers
+        qreal margin = 10.0;
+        BackgroundRaster *bgr = m_project->getBackgroundRaster();
+        if(bgr)
+            margin /= bgr->mapScale();
+        return m_bbox.marginsAdded(QMarginsF(margin,margin,margin,margin));
+    }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override
+    {
+        painter->save();
+        QPen p;
+        p.setCosmetic(true);
+        p.setCapStyle(Qt::RoundCap);
+        p.setColor(QColor(255,128,0,160));
+        p.setWidth(9);
+        painter->setPen(p);
+        painter->drawLines(m_segments);
+        p.setColor(Qt::red);
+        p.setWidth(12);
+        painter->setPen(p);
+        painter->drawPoints(m_crossings);
+        painter->restore();
+    }
+
+    int type() const override {return HazardHighlightType;}
+
+    void setReport(HazardReport const &report)
+    {
+        m_report = report;
+        updateProjectedPoints();
+    }
+
+    void updateProjectedPoints()
+    {
+        prepareGeometryChange();
+        auto toPixel = [this](QPointF const &p){return geoToPixel(QGeoCoordinate(p.y(),p.x()),m_project);};
+        m_crossings.clear();
+        m_segments.clear();
+        m_bbox = QRectF();
+        for(auto const &c: m_report.crossings)
+            m_crossings << toPixel(c);
+        for(auto const &s: m_report.segments)
+            m_segments << QLineF(toPixel(s.p1()),toPixel(s.p2()));
+        QPolygonF all = m_crossings;
+        for(auto const &s: m_segments)
+            all << s.p1() << s.p2();
+        m_bbox = all.boundingRect();
+    }
+
+private:
+    AutonomousVehicleProject *m_project;
+    HazardReport m_report;
+    QPolygonF m_crossings;
+    QVector<QLineF> m_segments;
+    QRectF m_bbox;
+};
+
+namespace
+{
+    qreal cross(QPointF const &a, QPointF const &b)
+    {
+        return a.x()*b.y()-a.y()*b.x();
+    }
+
+    bool intersection(QPointF const &a, QPointF const &b, QPointF const &p, QPointF const &q, QPointF &ret)
+    {
+        QPointF r = b-a;
+        QPointF s = q-p;
+        qreal d = cross(r,s);
+        if(d == 0.0)
+            return false;
+        qreal t = cross(p-a,s)/d;
+        qreal u = cross(p-a,r)/d;
+        if(t < 0.0 || t > 1.0 || u < 0.0 || u > 1.0)
+            return false;
+        ret = a+r*t;
+        return true;
+    }
+}
+
+HazardCheckWorker::HazardCheckWorker(HazardChecker* checker):m_checker(checker)
+{
+}
+
+void HazardCheckWorker::setHazards(QVector<PackedGeometry> const &layers)
+{
+    m_hazards.clear();
+    for(auto const &features: layers)
+        for(int f = 0; f < features.featureCount(); f++)
+            if(features.featureType(f) != PackedGeometry::PointFeature)
+                m_hazards.appendFeature(features,f);
+    std::vector<QRectF> bounds;
+    bounds.reserve(m_hazards.featureCount());
+    for(int f = 0; f < m_hazards.featureCount(); f++)
+    {
+        QPolygonF points;
+        int begin = m_hazards.firstCoordinate(m_hazards.firstRing(f));
+        int end = m_hazards.firstCoordinate(m_hazards.firstRing(f)+m_hazards.ringCount(f));
+        for(int i = begin; i < end; i++)
+            points << m_hazards.coordinate(i);
+        bounds.push_back(points.boundingRect());
+    }
+    m_index.build(bounds);
+}
+
+void HazardCheckWorker::checkSegment(QPointF const &a, QPointF const &b, HazardReport &report) const
+{
+    bool hazardous = false;
+    for(int f: m_index.queryLine(QPolygonF() << a << b))
+    {
+        bool polygon = m_hazards.featureType(f) == PackedGeometry::PolygonFeature;
+        bool inside = false;
+        for(int r = m_hazards.firstRing(f); r < m_hazards.firstRing(f)+m_hazards.ringCount(f); r++)
+        {
+            int begin = m_hazards.firstCoordinate(r);
+            int end = m_hazards.firstCoordinate(r+1);
+            QPointF crossing;
+            for(int i = begin+1; i < end; i++)
+                if(intersection(a,b,m_hazards.coordinate(i-1),m_hazards.coordinate(i),crossing))
+                {
+                    report.crossings << crossing;
+                    hazardous = true;
+                }
+            if(polygon && end-begin > 2)
+            {
+                if(m_hazards.coordinate(end-1) != m_hazards.coordinate(begin) && intersection(a,b,m_hazards.coordinate(end-1),m_hazards.coordinate(begin),crossing))
+                {
+                    report.crossings << crossing;
+                    hazardous = true;
+                }
+                // even-odd over all rings so holes are safe water
+                for(int i = begin, j = end-1; i < end; j = i++)
+                {
+                    QPointF const &pi = m_hazards.coordinate(i);
+                    QPointF const &pj = m_hazards.coordinate(j);
+                    if((pi.y() > a.y()) != (pj.y() > a.y()) && a.x() < pj.x()+(pi.x()-pj.x())*(a.y()-pj.y())/(pi.y()-pj.y()))
+                        inside = !inside;
+                }
+            }
+        }
+        hazardous = hazardous || inside;
+    }
+    if(hazardous)
+        report.segments << QLineF(a,b);
+}
+
+void HazardCheckWorker::check(quintptr item, int generation, QVector<QPolygonF> const &lines)
+{
+    HazardReport report;
+    for(auto const &line: lines)
+    {
+        // drop work made stale by a newer edit of the same item
+        if(!m_checker->isCurrent(item,generation))
+            return;
+        for(int i = 0; i+1 < line.size(); i++)
+            checkSegment(line[i],line[i+1],report);
+    }
+    emit checked(item,generation,report);
+}
+
+HazardChecker::HazardChecker(AutonomousVehicleProject* project):QObject(project),m_project(project),m_thread(new QThread()),m_worker(new HazardCheckWorker(this)),m_hasHazards(false)
+{
+    qRegisterMetaType<HazardReport>();
+    qRegisterMetaType<QVector<PackedGeometry> >();
+    qRegisterMetaType<QVector<QPolygonF> >();
+
+    m_worker->moveToThread(m_thread);
+    connect(this, &HazardChecker::hazardsUpdated, m_worker, &HazardCheckWorker::setHazards);
+    connect(this, &HazardChecker::checkRequested, m_worker, &HazardCheckWorker::check);
+    connect(m_worker, &HazardCheckWorker::checked, this, &HazardChecker::onChecked);
+    m_thread->start();
+
+    connect(project, &QAbstractItemModel::rowsInserted, this, &HazardChecker::onRowsInserted);
+    connect(project, &QAbstractItemModel::rowsRemoved, this, &HazardChecker::onRowsRemoved);
+    connect(project, &AutonomousVehicleProject::backgroundUpdated, this, &HazardChecker::updateHighlights);
+}
+
+HazardChecker::~HazardChecker()
+{
+    m_thread->quit();
+    m_thread->wait();
+    delete m_worker;
+    delete m_thread;
+}
+
+bool HazardChecker::isCurrent(quintptr item, int generation)
+{
+    QMutexLocker lock(&m_generationsMutex);
+    return m_generations.value(item) == generation;
+}
+
+void HazardChecker::onRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    for(int row = first; row <= last; row++)
+        watch(m_project->itemFromIndex(m_project->index(row,0,parent)));
+    recheckParent(parent);
+}
+
+void HazardChecker::onRowsRemoved(const QModelIndex& parent, int, int)
+{
+    recheckParent(parent);
+}
+
+void HazardChecker::recheckParent(const QModelIndex& parent)
+{
+    // waypoints added or removed outside of the item's own editing
+    quintptr id = quintptr(qobject_cast<GeoGraphicsMissionItem*>(m_project->itemFromIndex(parent)));
+    if(id && m_items.value(id))
+        check(m_items[id]);
+}
+
+void HazardChecker::watch(MissionItem* item)
+{
+    if(!item)
+        return;
+    TrackLine *tl = qobject_cast<TrackLine*>(item);
+    if(tl)
+        connect(tl, &TrackLine::trackLineUpdated, this, [this,tl](){check(tl);});
+    SurveyPattern *sp = qobject_cast<SurveyPattern*>(item);
+    if(sp)
+        connect(sp, &SurveyPattern::surveyPatternUpdated, this, [this,sp](){check(sp);});
+    if(tl || sp)
+    {
+        quintptr id = quintptr(static_cast<GeoGraphicsMissionItem*>(item));
+        connect(item, &QObject::destroyed, this, [this,id]()
+        {
+            // the highlight went with the item's graphics children
+            m_items.remove(id);
+            m_highlights.remove(id);
+            QMutexLocker lock(&m_generationsMutex);
+            m_generations.remove(id);
+        });
+        check(static_cast<GeoGraphicsMissionItem*>(item));
+    }
+    VectorDataset *vd = qobject_cast<VectorDataset*>(item);
+    if(vd)
+    {
+        connect(vd, &VectorDataset::loadFinished, this, &HazardChecker::updateHazards);
+        connect(vd, &QObject::destroyed, this, &HazardChecker::updateHazards, Qt::QueuedConnection);
+    }
+    for(auto child: item->childMissionItems())
+        watch(child);
+}
+
+void HazardChecker::updateHazards()
+{
+    // one bulk copy per layer here; the features are picked out on the worker
+    QVector<PackedGeometry> layers;
+    int featureCount = 0;
+    for(auto layer: m_project->vectorLayers())
+    {
+        layers.append(layer->features());
+        featureCount += layer->features().featureCount();
+    }
+    if(featureCount == 0 && !m_hasHazards)
+        return;
+    m_hasHazards = featureCount > 0;
+    emit hazardsUpdated(layers);
+    for(auto item: m_items.values())
+        if(item)
+            check(item);
+}
+
+void HazardChecker::check(GeoGraphicsMissionItem* item)
+{
+    quintptr id = quintptr(item);
+    m_items[id] = item;
+    if(!m_hasHazards && !m_highlights.contains(id))
+        return;
+
+    QVector<QPolygonF> lines;
+    for(auto const &line: item->getLines())
+    {
+        QPolygonF polyline;
+        for(auto const &c: line)
+            polyline << QPointF(c.longitude(),c.latitude());
+        lines << polyline;
+    }
+    int generation;
+    {
+        QMutexLocker lock(&m_generationsMutex);
+        generation = ++m_generations[id];
+    }
+    emit checkRequested(id,generation,lines);
+}
+
+void HazardChecker::onChecked(quintptr item, int generation, const HazardReport& report)
+{
+    if(!isCurrent(item,generation) || !m_items.value(item))
+        return;
+    HazardHighlight *highlight = m_highlights.value(item);
+    if(!highlight)
+    {
+        if(report.crossings.empty() && report.segments.empty())
+            return;
+        highlight = new HazardHighlight(m_project,m_items[item].data());
+        m_highlights[item] = highlight;
+    }
+    highlight->setReport(report);
+}
+
+void HazardChecker::updateHighlights()
+{
+    for(auto highlight: m_highlights)
+        highlight->updateProjectedPoints();
+}
@@ -0,0 +1,100 @@
+#ifndef HAZARDCHECKER_H
+#define HAZARDCHECKER_H
+
+#include <QObject>
+#include <QHash>
+#include <QLineF>
+#include <QModelIndex>
+#include <QMutex>
+#include <QPointer>
+#include <QPolygonF>
+#include <QVector>
+#include "packedgeometry.h"
+#include "rtree.h"
+
+class AutonomousVehicleProject;
+class MissionItem;
+class GeoGraphicsMissionItem;
+class QThread;
+class HazardHighlight;
+
+/// Where a plan item meets hazards. Coordinates are (longitude, latitude).
+struct HazardReport
+{
+    QPolygonF crossings;
+    QVector<QLineF> segments;
+};
+
+Q_DECLARE_METATYPE(HazardReport)
+
+class HazardChecker;
+
+/// Runs the geometry tests for HazardChecker on its thread.
+class HazardCheckWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HazardCheckWorker(HazardChecker *checker);
+
+public slots:
+    /// Keeps the line and polygon features of the given layers.
+    void setHazards(QVector<PackedGeometry> const &layers);
+    void check(quintptr item, int generation, QVector<QPolygonF> const &lines);
+
+signals:
+    void checked(quintptr item, int generation, HazardReport const &report);
+
+private:
+    HazardChecker *m_checker;
+    PackedGeometry m_hazards;
+    RTree m_index;
+
+    void checkSegment(QPointF const &a, QPointF const &b, HazardReport &report) const;
+};
+
+/// Checks track lines and survey patterns against the line and polygon
+/// features of the project's vector layers on a worker thread. An item is
+/// re-checked on its own whenever its geometry changes and the places where
+/// it meets a hazard are highlighted on it.
+class HazardChecker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HazardChecker(AutonomousVehicleProject *project);
+    ~HazardChecker();
+
+    /// False once a newer check of the same item has been requested.
+    bool isCurrent(quintptr item, int generation);
+
+public slots:
+    /// Rebuilds the hazard set from all vector layers and re-checks every item.
+    void updateHazards();
+    void check(GeoGraphicsMissionItem *item);
+
+signals:
+    void hazardsUpdated(QVector<PackedGeometry> const &layers);
+    void checkRequested(quintptr item, int generation, QVector<QPolygonF> const &lines);
+
+private slots:
+    void onRowsInserted(QModelIndex const &parent, int first, int last);
+    void onRowsRemoved(QModelIndex const &parent, int first, int last);
+    void onChecked(quintptr item, int generation, HazardReport const &report);
+    void updateHighlights();
+
+private:
+    AutonomousVehicleProject *m_project;
+    QThread *m_thread;
+    HazardCheckWorker *m_worker;
+    QHash<quintptr, QPointer<GeoGraphicsMissionItem> > m_items;
+    QHash<quintptr, HazardHighlight *> m_highlights;
+    QHash<quintptr, int> m_generations;
+    QMutex m_generationsMutex;
+    bool m_hasHazards;
+
+    void watch(MissionItem *item);
+    void recheckParent(QModelIndex const &parent);
+};
+
+#endif // HAZARDCHECKER_H
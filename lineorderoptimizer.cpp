@@ -0,0 +1,241 @@
+#include "lineorderoptimizer.h"
+#include <QElapsedTimer>
+#include <QtMath>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    const double earthRadius = 6371000.0;
+
+    double distance(QPointF const &a, QPointF const &b)
+    {
+        QPointF d = b-a;
+        return qSqrt(d.x()*d.x()+d.y()*d.y());
+    }
+}
+
+void LineOrderOptimizer::addLine(QGeoCoordinate const &start, QGeoCoordinate const &end, bool reversible)
+{
+    if(!m_reference.isValid())
+        m_reference = start;
+
+    // Equirectangular about the first point is plenty for comparing transits
+    // within a survey.
+    double scale = earthRadius*M_PI/180.0;
+    double lonScale = scale*qCos(qDegreesToRadians(m_reference.latitude()));
+    m_starts.push_back(QPointF((start.longitude()-m_reference.longitude())*lonScale,(start.latitude()-m_reference.latitude())*scale));
+    m_ends.push_back(QPointF((end.longitude()-m_reference.longitude())*lonScale,(end.latitude()-m_reference.latitude())*scale));
+    m_reversible.push_back(reversible);
+}
+
+QPointF LineOrderOptimizer::entry(Step const &step) const
+{
+    return step.reversed ? m_ends[step.index] : m_starts[step.index];
+}
+
+QPointF LineOrderOptimizer::exit(Step const &step) const
+{
+    return step.reversed ? m_starts[step.index] : m_ends[step.index];
+}
+
+double LineOrderOptimizer::cost(Tour const &tour) const
+{
+    double ret = 0.0;
+    for(std::size_t i = 1; i < tour.size(); i++)
+        ret += distance(exit(tour[i-1]),entry(tour[i]));
+    return ret;
+}
+
+double LineOrderOptimizer::transitDistance(QList<Step> const &order) const
+{
+    return cost(Tour(order.begin(),order.end()));
+}
+
+LineOrderOptimizer::Tour LineOrderOptimizer::nearestNeighbour(Step const &first) const
+{
+    Tour ret;
+    std::vector<bool> used(m_starts.size(),false);
+    ret.push_back(first);
+    used[first.index] = true;
+    while(ret.size() < m_starts.size())
+    {
+        QPointF position = exit(ret.back());
+        Step best = {-1,false};
+        double bestDistance = std::numeric_limits<double>::max();
+        for(std::size_t i = 0; i < m_starts.size(); i++)
+        {
+            if(used[i])
+                continue;
+            double d = distance(position,m_starts[i]);
+            if(d < bestDistance)
+            {
+                bestDistance = d;
+                best.index = i;
+                best.reversed = false;
+            }
+            if(m_reversible[i])
+            {
+                d = distance(position,m_ends[i]);
+                if(d < bestDistance)
+                {
+                    bestDistance = d;
+                    best.index = i;
+                    best.reversed = true;
+                }
+            }
+        }
+        ret.push_back(best);
+        used[best.index] = true;
+    }
+    return ret;
+}
+
+bool LineOrderOptimizer::twoOpt(Tour &tour) const
+{
+    // Reversing a run of lines also flips each of them, so the run may only
+    // contain reversible lines. A run of one is a plain flip.
+    int n = tour.size();
+    std::vector<int> fixedBefore(n+1,0);
+    for(int i = 0; i < n; i++)
+        fixedBefore[i+1] = fixedBefore[i]+(m_reversible[tour[i].index] ? 0 : 1);
+
+    bool improved = false;
+    for(int i = 0; i < n; i++)
+        for(int j = i; j < n && fixedBefore[j+1] == fixedBefore[i]; j++)
+        {
+            double before = 0.0;
+            double after = 0.0;
+            if(i > 0)
+            {
+                before += distance(exit(tour[i-1]),entry(tour[i]));
+                after += distance(exit(tour[i-1]),exit(tour[j]));
+            }
+            if(j+1 < n)
+            {
+                before += distance(exit(tour[j]),entry(tour[j+1]));
+                after += distance(entry(tour[i]),entry(tour[j+1]));
+            }
+            if(after < before-1e-6)
+            {
+                std::reverse(tour.begin()+i,tour.begin()+j+1);
+                for(int k = i; k <= j; k++)
+                    tour[k].reversed = !tour[k].reversed;
+                improved = true;
+            }
+        }
+    return improved;
+}
+
+bool LineOrderOptimizer::orOpt(Tour &tour) const
+{
+    // Moves runs of up to three lines elsewhere in the tour, flipped if allowed.
+    int n = tour.size();
+    bool improved = false;
+    for(int length = 1; length <= 3 && length < n; length++)
+        for(int i = 0; i+length <= n; i++)
+        {
+            int last = i+length-1;
+            bool reversible = true;
+            for(int k = i; k <= last; k++)
+                reversible = reversible && m_reversible[tour[k].index];
+
+            double removed = 0.0;
+            if(i > 0)
+                removed += distance(exit(tour[i-1]),entry(tour[i]));
+            if(last+1 < n)
+                removed += distance(exit(tour[last]),entry(tour[last+1]));
+            if(i > 0 && last+1 < n)
+                removed -= distance(exit(tour[i-1]),entry(tour[last+1]));
+
+            double bestDelta = -1e-6;
+            int bestPosition = -2;
+            bool bestFlip = false;
+            // insert between p and p+1 of the tour with the run taken out
+            for(int p = -1; p < n; p++)
+            {
+                if(p >= i-1 && p <= last)
+                    continue;
+                bool hasA = p >= 0;
+                bool hasB = p+1 < n;
+                for(int flip = 0; flip < (reversible ? 2 : 1); flip++)
+                {
+                    QPointF runEntry = flip ? exit(tour[last]) : entry(tour[i]);
+                    QPointF runExit = flip ? entry(tour[i]) : exit(tour[last]);
+                    double added = 0.0;
+                    if(hasA)
+                        added += distance(exit(tour[p]),runEntry);
+                    if(hasB)
+                        added += distance(runExit,entry(tour[p+1]));
+                    if(hasA && hasB)
+                        added -= distance(exit(tour[p]),entry(tour[p+1]));
+                    if(added-removed < bestDelta)
+                    {
+                        bestDelta = added-removed;
+                        bestPosition = p;
+                        bestFlip = flip;
+                    }
+                }
+            }
+            if(bestPosition > -2)
+            {
+                Tour run(tour.begin()+i,tour.begin()+last+1);
+                if(bestFlip)
+                {
+                    std::reverse(run.begin(),run.end());
+                    for(auto &s: run)
+                        s.reversed = !s.reversed;
+                }
+                tour.erase(tour.begin()+i,tour.begin()+last+1);
+                int insertAt = bestPosition < i ? bestPosition+1 : bestPosition+1-length;
+                tour.insert(tour.begin()+insertAt,run.begin(),run.end());
+                improved = true;
+            }
+        }
+    return improved;
+}
+
+QList<LineOrderOptimizer::Step> LineOrderOptimizer::optimize(QList<Step> const &initial, int timeBudget) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Tour best(initial.begin(),initial.end());
+    if(best.size() != m_starts.size())
+    {
+        best.clear();
+        for(std::size_t i = 0; i < m_starts.size(); i++)
+        {
+            Step s = {int(i),false};
+            best.push_back(s);
+        }
+    }
+    double bestCost = cost(best);
+
+    // Anytime multi-start: the given order first, then nearest neighbour tours
+    // starting from each line, each improved until no move helps.
+    for(int start = -1; best.size() > 1 && start < int(m_starts.size()) && !timer.hasExpired(timeBudget); start++)
+    {
+        Tour tour;
+        if(start < 0)
+            tour = best;
+        else
+        {
+            Step first = {start,false};
+            tour = nearestNeighbour(first);
+        }
+        while(!timer.hasExpired(timeBudget) && (twoOpt(tour) | orOpt(tour)))
+            ;
+        double c = cost(tour);
+        if(c < bestCost)
+        {
+            bestCost = c;
+            best = tour;
+        }
+    }
+
+    QList<Step> ret;
+    for(auto const &s: best)
+        ret.append(s);
+    return ret;
+}
@@ -0,0 +1,47 @@
+#ifndef LINEORDEROPTIMIZER_H
+#define LINEORDEROPTIMIZER_H
+
+#include <QGeoCoordinate>
+#include <QList>
+#include <QPointF>
+#include <vector>
+
+/// Orders a set of lines, each run from a start to an end point, to minimize the
+/// transit between the end of one line and the start of the next. Lines flagged
+/// as reversible may be run end to start.
+class LineOrderOptimizer
+{
+public:
+    struct Step
+    {
+        int index;
+        bool reversed;
+    };
+
+    void addLine(QGeoCoordinate const &start, QGeoCoordinate const &end, bool reversible);
+
+    /// Improves the given order, then tries nearest neighbour tours from each line
+    /// in turn, polishing each with 2-opt and Or-opt moves until timeBudget (ms)
+    /// runs out. Returns the best order found, never worse than the given one.
+    QList<Step> optimize(QList<Step> const &initial, int timeBudget = 500) const;
+
+    /// Total transit distance in meters for running the lines in order.
+    double transitDistance(QList<Step> const &order) const;
+
+private:
+    typedef std::vector<Step> Tour;
+
+    QPointF entry(Step const &step) const;
+    QPointF exit(Step const &step) const;
+    double cost(Tour const &tour) const;
+    Tour nearestNeighbour(Step const &first) const;
+    bool twoOpt(Tour &tour) const;
+    bool orOpt(Tour &tour) const;
+
+    QGeoCoordinate m_reference;
+    std::vector<QPointF> m_starts;
+    std::vector<QPointF> m_ends;
+    std::vector<bool> m_reversible;
+};
+
+#endif // LINEORDEROPTIMIZER_H
@@ -2,16 +2,18 @@
 #include <QPainter>
 #include "point.h"
 
-LineString::LineString(MissionItem* parent):GeoGraphicsMissionItem(parent)
+LineString::LineString(MissionItem* parent):GeoGraphicsMissionItem(parent),m_pyramidDirty(true)
 {
 
 }
 
 void LineString::updateProjectedPoints()
 {
-    for(auto p: m_points)
+    prepareGeometryChange();
+    for(auto &p: m_points)
         p.pos = geoToPixel(p.location,autonomousVehicleProject());
     updateBBox();
+    m_pyramidDirty = true;
 }
 
 void LineString::write(QJsonObject& json) const
@@ -47,16 +49,25 @@ void LineString::paint(QPainter* painter, const QStyleOptionGraphicsItem* option
         p.setWidth(3);
         painter->setPen(p);
 
-        auto first = m_points.begin();
-        auto second = first;
-        second++;
-        while(second != m_points.end())
+        if(m_pyramidDirty)
         {
-            painter->drawLine(first->pos,second->pos);
-            first++;
-            second++;
+            m_pixels.clear();
+            m_pixels.reserve(m_points.size());
+            for(auto const &p: m_points)
+                m_pixels.push_back(p.pos);
+            std::vector<int> ringOffsets;
+            ringOffsets.push_back(0);
+            ringOffsets.push_back(m_pixels.size());
+            m_pyramid.build(m_pixels.data(),ringOffsets);
+            m_pyramidDirty = false;
         }
 
+        int level = m_pyramid.levelFor(painter->worldTransform());
+        if(level >= 0)
+            painter->drawPolyline(m_pyramid.ring(level,0),m_pyramid.ringSize(level,0));
+        else
+            painter->drawPolyline(m_pixels.data(),m_pixels.size());
+
         painter->restore();
 
     }
@@ -94,8 +105,13 @@ void LineString::addPoint(const QGeoCoordinate &location)
     LocationPosition lp;
     lp.location = location;
     lp.pos = geoToPixel(location,autonomousVehicleProject());
+    prepareGeometryChange();
     m_points.append(lp);
-    updateBBox();
+    if(m_points.length() == 1)
+        m_bbox = QRectF(lp.pos,QSizeF());
+    else
+        growBBox(lp.pos);
+    m_pyramidDirty = true;
 }
 
 void LineString::updateBBox()
@@ -104,9 +120,18 @@ void LineString::updateBBox()
     {
         m_bbox = QRectF(m_points[0].pos,QSizeF());
         for(auto p:m_points)
-            m_bbox = m_bbox.united(QRectF(p.pos,QSizeF()));
+            growBBox(p.pos);
     }
     else
         m_bbox = QRectF();
 }
 
+void LineString::growBBox(QPointF const &pos)
+{
+    // QRectF::united ignores the zero sized rectangle of a single point
+    m_bbox.setLeft(std::min(m_bbox.left(),pos.x()));
+    m_bbox.setRight(std::max(m_bbox.right(),pos.x()));
+    m_bbox.setTop(std::min(m_bbox.top(),pos.y()));
+    m_bbox.setBottom(std::max(m_bbox.bottom(),pos.y()));
+}
+
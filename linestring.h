@@ -3,6 +3,7 @@
 
 #include "geographicsmissionitem.h"
 #include "locationposition.h"
+#include "simplificationpyramid.h"
 
 class LineString : public GeoGraphicsMissionItem
 {
@@ -31,8 +32,12 @@ public slots:
 private:
     QList<LocationPosition> m_points;
     QRectF m_bbox;
+    std::vector<QPointF> m_pixels;
+    SimplificationPyramid m_pyramid;
+    bool m_pyramidDirty;
     
     void updateBBox();
+    void growBBox(QPointF const &pos);
     
 };
 
@@ -2,6 +2,8 @@
 #include "ui_mainwindow.h"
 #include <QFileDialog>
 #include <QStandardItemModel>
+#include <QInputDialog>
+#include <QProgressDialog>
 #include <gdal_priv.h>
 #include <cstdint>
 
@@ -16,6 +18,9 @@
 #include "backgroundraster.h"
 #include "trackline.h"
 #include "surveypattern.h"
+#include "surveyarea.h"
+#include "group.h"
+#include "vectordataset.h"
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -41,12 +46,16 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->rosDetails->setEnabled(false);
 #ifdef AMP_ROS
     connect(project->rosLink(), &ROSLink::rosConnected,this,&MainWindow::onROSConnected);
+    connect(project->rosLink(), &ROSLink::replayFinished,this,&MainWindow::onReplayFinished);
     ui->rosDetails->setROSLink(project->rosLink());
 
     project->rosLink()->connectROS();
+#else
+    ui->menu_ROS->menuAction()->setVisible(false);
 #endif
     
     connect(ui->projectView,&ProjectView::scaleChanged,project,&AutonomousVehicleProject::updateMapScale);
+    connect(ui->projectView,&ProjectView::areaSelected,this,&MainWindow::openGeometry);
 }
 
 MainWindow::~MainWindow()
@@ -95,6 +104,11 @@ void MainWindow::on_treeView_customContextMenuRequested(const QPoint &pos)
 #ifdef AMP_ROS
     QAction *sendToROSAction = menu.addAction("Send to ROS");
     connect(sendToROSAction, &QAction::triggered, this, &MainWindow::sendToROS);
+    if(project->rosLink()->adaptiveSpacingActive())
+    {
+        QAction *stopAdaptiveAction = menu.addAction("Stop Adaptive Spacing");
+        connect(stopAdaptiveAction, &QAction::triggered, [=](){this->project->rosLink()->stopAdaptiveSpacing();});
+    }
 #endif
 
 
@@ -135,6 +149,18 @@ void MainWindow::on_treeView_customContextMenuRequested(const QPoint &pos)
         {
             QAction *reverseDirectionAction = menu.addAction("Reverse Direction");
             connect(reverseDirectionAction, &QAction::triggered, tl, &TrackLine::reverseDirection);
+#ifdef AMP_ROS
+            auto wps = tl->waypoints();
+            if(wps.size() > 1)
+            {
+                QGeoCoordinate start = wps.front()->location();
+                QGeoCoordinate end = wps.back()->location();
+                QAction *adaptiveStarboardAction = menu.addAction("Adaptive Spacing to Starboard");
+                connect(adaptiveStarboardAction, &QAction::triggered, [=](){this->startAdaptiveSpacing(start,end,true);});
+                QAction *adaptivePortAction = menu.addAction("Adaptive Spacing to Port");
+                connect(adaptivePortAction, &QAction::triggered, [=](){this->startAdaptiveSpacing(start,end,false);});
+            }
+#endif
         }
 
         SurveyPattern *sp = qobject_cast<SurveyPattern*>(mi);
@@ -144,6 +170,20 @@ void MainWindow::on_treeView_customContextMenuRequested(const QPoint &pos)
             connect(reverseDirectionAction, &QAction::triggered, sp, &SurveyPattern::reverseDirection);
         }
         
+        Group *group = qobject_cast<Group*>(mi);
+        if(group)
+        {
+            QAction *optimizeOrderAction = menu.addAction("Optimize Line Order");
+            connect(optimizeOrderAction, &QAction::triggered, [=](){group->optimizeLineOrder();});
+        }
+        
+        SurveyArea *sa = qobject_cast<SurveyArea*>(mi);
+        if(sa && project->platforms().size() > 1)
+        {
+            QAction *partitionAction = menu.addAction("Partition Between Platforms");
+            connect(partitionAction, &QAction::triggered, [=](){sa->partition(this->project->platforms());});
+        }
+        
         GeoGraphicsMissionItem *gmi = qobject_cast<GeoGraphicsMissionItem*>(mi);
         if(gmi)
         {
@@ -163,6 +203,54 @@ void MainWindow::on_treeView_customContextMenuRequested(const QPoint &pos)
     menu.exec(ui->treeView->mapToGlobal(pos));
 }
 
+#ifdef AMP_ROS
+void MainWindow::startAdaptiveSpacing(QGeoCoordinate const &start, QGeoCoordinate const &end, bool starboard)
+{
+    bool ok;
+    double overlap = QInputDialog::getDouble(this, "Adaptive Spacing", "Swath overlap (%):", 10.0, 0.0, 90.0, 0, &ok);
+    if(ok)
+        project->rosLink()->startAdaptiveSpacing(start,end,starboard,overlap/100.0);
+}
+
+#endif
+
+void MainWindow::on_actionRecordTelemetry_triggered(bool checked)
+{
+#ifdef AMP_ROS
+    if(!checked)
+    {
+        project->rosLink()->stopRecording();
+        return;
+    }
+    QString fname = QFileDialog::getSaveFileName(this,tr("Record Telemetry"));
+    if(fname.isEmpty() || !project->rosLink()->startRecording(fname))
+        ui->actionRecordTelemetry->setChecked(false);
+#endif
+}
+
+void MainWindow::on_actionReplayTelemetry_triggered()
+{
+#ifdef AMP_ROS
+    QString fname = QFileDialog::getOpenFileName(this,tr("Replay Telemetry"));
+    if(fname.isEmpty())
+        return;
+    bool ok;
+    double speed = QInputDialog::getDouble(this, "Replay Telemetry", "Speed (0 for as fast as possible):", 1.0, 0.0, 1000.0, 1, &ok);
+    if(ok && project->rosLink()->startReplay(fname,speed))
+    {
+        ui->actionReplayTelemetry->setEnabled(false);
+        ui->actionStopReplay->setEnabled(true);
+    }
+#endif
+}
+
+void MainWindow::on_actionStopReplay_triggered()
+{
+#ifdef AMP_ROS
+    project->rosLink()->stopReplay();
+#endif
+}
+
 void MainWindow::exportHypack() const
 {
     project->exportHypack(ui->treeView->selectionModel()->currentIndex());
@@ -224,11 +312,48 @@ void MainWindow::on_actionBehavior_triggered()
 }
 
 void MainWindow::on_actionOpenGeometry_triggered()
+{
+    openGeometry(QGeoRectangle());
+}
+
+void MainWindow::on_actionOpenGeometryInBackground_triggered()
+{
+    BackgroundRaster *bg = project->getBackgroundRaster();
+    if(bg)
+    {
+        QRectF extent = bg->boundingRect();
+        openGeometry(QGeoRectangle(QList<QGeoCoordinate>() << bg->pixelToGeo(extent.topLeft()) << bg->pixelToGeo(extent.bottomRight())));
+    }
+    else
+        openGeometry(QGeoRectangle());
+}
+
+void MainWindow::on_actionOpenGeometryInBox_triggered()
+{
+    ui->projectView->setSelectAreaMode();
+}
+
+void MainWindow::openGeometry(QGeoRectangle const &area)
 {
     QString fname = QFileDialog::getOpenFileName(this,tr("Open"));
 
     if(!fname.isEmpty())
-        project->openGeometry(fname);
+    {
+        VectorDataset *vd = project->openGeometry(fname,area);
+        if(vd->loading())
+        {
+            QProgressDialog *progress = new QProgressDialog(tr("Loading ")+fname, tr("Cancel"), 0, 0, this);
+            progress->setAttribute(Qt::WA_DeleteOnClose);
+            progress->setMinimumDuration(500);
+            connect(vd, &VectorDataset::loadProgress, progress, [=](qint64 featuresRead, qint64 featureCount)
+            {
+                progress->setMaximum(featureCount);
+                progress->setValue(std::min(featuresRead,featureCount));
+            });
+            connect(vd, &VectorDataset::loadFinished, progress, &QProgressDialog::close);
+            connect(progress, &QProgressDialog::canceled, vd, &VectorDataset::cancelLoading);
+        }
+    }
 }
 
 void MainWindow::on_actionGroup_triggered()
@@ -239,6 +364,20 @@ void MainWindow::on_actionGroup_triggered()
 void MainWindow::onROSConnected(bool connected)
 {
     ui->rosDetails->setEnabled(connected);
+    // replays are refused while live
+    ui->actionReplayTelemetry->setEnabled(!connected);
+}
+
+void MainWindow::onReplayFinished()
+{
+#ifdef AMP_ROS
+    // a replay started since may still be running
+    if(project->rosLink()->replaying())
+        return;
+    // the details are enabled while connected
+    ui->actionReplayTelemetry->setEnabled(!ui->rosDetails->isEnabled());
+    ui->actionStopReplay->setEnabled(false);
+#endif
 }
 
 
@@ -9,6 +9,8 @@ class MainWindow;
 }
 
 class AutonomousVehicleProject;
+class QGeoCoordinate;
+class QGeoRectangle;
 
 class MainWindow : public QMainWindow
 {
@@ -22,6 +24,7 @@ public slots:
 
     void setCurrent(QModelIndex &index);
     void onROSConnected(bool connected);
+    void onReplayFinished();
 
 private slots:
     void on_actionOpen_triggered();
@@ -35,9 +38,15 @@ private slots:
     void on_actionSurveyArea_triggered();
     void on_actionPlatform_triggered();
     void on_actionOpenGeometry_triggered();
+    void on_actionOpenGeometryInBackground_triggered();
+    void on_actionOpenGeometryInBox_triggered();
+    void openGeometry(QGeoRectangle const &area);
     void on_actionGroup_triggered();
     void on_actionImport_triggered();
     void on_actionBehavior_triggered();
+    void on_actionRecordTelemetry_triggered(bool checked);
+    void on_actionReplayTelemetry_triggered();
+    void on_actionStopReplay_triggered();
 
 private:
     Ui::MainWindow *ui;
@@ -46,6 +55,9 @@ private:
     void exportHypack() const;
     void exportMissionPlan() const;
     void sendToROS() const;
+#ifdef AMP_ROS
+    void startAdaptiveSpacing(QGeoCoordinate const &start, QGeoCoordinate const &end, bool starboard);
+#endif
 };
 
 #endif // MAINWINDOW_H
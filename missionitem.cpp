@@ -5,6 +5,7 @@
 #include "waypoint.h"
 #include "trackline.h"
 #include "surveypattern.h"
+#include "surveyarea.h"
 #include "platform.h"
 #include "backgroundraster.h"
 #include "behavior.h"
@@ -82,6 +83,8 @@ void MissionItem::readChildren(const QJsonArray& json)
             item = project->createTrackLine();
         if(object["type"] == "SurveyPattern")
             item = project->createSurveyPattern();
+        if(object["type"] == "SurveyArea")
+            item = project->createSurveyArea();
         if(object["type"] == "Platform")
             item = project->createPlatform();
         if(item)
@@ -110,6 +113,12 @@ void MissionItem::removeChildMissionItem(MissionItem* cmi)
     m_childrenMissionItems.removeAll(cmi);
 }
 
+void MissionItem::setChildMissionItemsOrder(const QList<MissionItem *>& order)
+{
+    if(order.size() == m_childrenMissionItems.size())
+        m_childrenMissionItems = order;
+}
+
 void MissionItem::writeBehaviorsToMissionPlanObject(QJsonObject& missionObject) const
 {
     QJsonObject behaviorsObject;
@@ -25,6 +25,7 @@ public:
 
     QList<MissionItem*> const &childMissionItems() const;
     void removeChildMissionItem(MissionItem *cmi);
+    void setChildMissionItemsOrder(QList<MissionItem *> const &order);
     
     int row() const;
     
@@ -0,0 +1,121 @@
+#include "packedgeometry.h"
+
+PackedGeometry::PackedGeometry()
+{
+    clear();
+}
+
+int PackedGeometry::featureCount() const
+{
+    return m_featureTypes.size();
+}
+
+PackedGeometry::FeatureType PackedGeometry::featureType(int feature) const
+{
+    return m_featureTypes[feature];
+}
+
+int PackedGeometry::firstRing(int feature) const
+{
+    return m_featureOffsets[feature];
+}
+
+int PackedGeometry::ringCount(int feature) const
+{
+    return m_featureOffsets[feature+1]-m_featureOffsets[feature];
+}
+
+int PackedGeometry::firstCoordinate(int ring) const
+{
+    return m_ringOffsets[ring];
+}
+
+int PackedGeometry::coordinateCount(int ring) const
+{
+    return m_ringOffsets[ring+1]-m_ringOffsets[ring];
+}
+
+bool PackedGeometry::isHole(int ring) const
+{
+    return m_ringHoles[ring];
+}
+
+int PackedGeometry::partCount(int feature) const
+{
+    int ret = 0;
+    for(int r = firstRing(feature); r < firstRing(feature)+ringCount(feature); r++)
+        if(!m_ringHoles[r])
+            ret++;
+    return ret;
+}
+
+int PackedGeometry::coordinateCount() const
+{
+    return m_coordinates.size();
+}
+
+QPointF const &PackedGeometry::coordinate(int index) const
+{
+    return m_coordinates[index];
+}
+
+void PackedGeometry::addFeature(FeatureType type)
+{
+    m_featureTypes.push_back(type);
+    m_featureOffsets.push_back(m_featureOffsets.back());
+}
+
+void PackedGeometry::addRing(bool hole)
+{
+    m_ringOffsets.push_back(m_ringOffsets.back());
+    m_ringHoles.push_back(hole);
+    m_featureOffsets.back()++;
+}
+
+void PackedGeometry::addCoordinate(double longitude, double latitude)
+{
+    m_coordinates.push_back(QPointF(longitude,latitude));
+    m_ringOffsets.back()++;
+}
+
+void PackedGeometry::append(PackedGeometry const &other)
+{
+    int ringBase = m_ringOffsets.size()-1;
+    int coordinateBase = m_coordinates.size();
+    m_coordinates.insert(m_coordinates.end(),other.m_coordinates.begin(),other.m_coordinates.end());
+    for(std::size_t i = 1; i < other.m_ringOffsets.size(); i++)
+        m_ringOffsets.push_back(coordinateBase+other.m_ringOffsets[i]);
+    m_ringHoles.insert(m_ringHoles.end(),other.m_ringHoles.begin(),other.m_ringHoles.end());
+    for(std::size_t i = 1; i < other.m_featureOffsets.size(); i++)
+        m_featureOffsets.push_back(ringBase+other.m_featureOffsets[i]);
+    m_featureTypes.insert(m_featureTypes.end(),other.m_featureTypes.begin(),other.m_featureTypes.end());
+}
+
+void PackedGeometry::appendFeature(PackedGeometry const &other, int feature)
+{
+    addFeature(other.featureType(feature));
+    for(int r = other.firstRing(feature); r < other.firstRing(feature)+other.ringCount(feature); r++)
+    {
+        addRing(other.isHole(r));
+        m_coordinates.insert(m_coordinates.end(),other.m_coordinates.begin()+other.firstCoordinate(r),other.m_coordinates.begin()+other.firstCoordinate(r+1));
+        m_ringOffsets.back() = m_coordinates.size();
+    }
+}
+
+void PackedGeometry::reserve(int features, int rings, int coordinates)
+{
+    m_featureTypes.reserve(features);
+    m_featureOffsets.reserve(features+1);
+    m_ringOffsets.reserve(rings+1);
+    m_ringHoles.reserve(rings);
+    m_coordinates.reserve(coordinates);
+}
+
+void PackedGeometry::clear()
+{
+    m_coordinates.clear();
+    m_ringOffsets.assign(1,0);
+    m_ringHoles.clear();
+    m_featureOffsets.assign(1,0);
+    m_featureTypes.clear();
+}
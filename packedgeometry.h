@@ -0,0 +1,53 @@
+#ifndef PACKEDGEOMETRY_H
+#define PACKEDGEOMETRY_H
+
+#include <QMetaType>
+#include <QPointF>
+#include <vector>
+
+/// Geometry of many features in contiguous arrays. Coordinates are stored as
+/// (longitude, latitude). A feature is a run of rings and a ring is a run of
+/// coordinates, both located through offset arrays that end with a sentinel.
+/// Multi-part features keep all their parts' rings in the one feature; a
+/// polygon part is its exterior ring followed by rings flagged as holes.
+class PackedGeometry
+{
+public:
+    enum FeatureType: unsigned char {PointFeature, LineStringFeature, PolygonFeature};
+
+    PackedGeometry();
+
+    int featureCount() const;
+    FeatureType featureType(int feature) const;
+    int firstRing(int feature) const;
+    int ringCount(int feature) const;
+    int firstCoordinate(int ring) const;
+    int coordinateCount(int ring) const;
+    bool isHole(int ring) const;
+    int partCount(int feature) const;
+    int coordinateCount() const;
+    QPointF const &coordinate(int index) const;
+
+    /// Starts a feature; its rings are added with addRing and addCoordinate.
+    void addFeature(FeatureType type);
+    void addRing(bool hole = false);
+    void addCoordinate(double longitude, double latitude);
+
+    void append(PackedGeometry const &other);
+    void appendFeature(PackedGeometry const &other, int feature);
+    void reserve(int features, int rings, int coordinates);
+    void clear();
+
+private:
+    friend class VectorCache;
+
+    std::vector<QPointF> m_coordinates;
+    std::vector<int> m_ringOffsets;
+    std::vector<unsigned char> m_ringHoles;
+    std::vector<int> m_featureOffsets;
+    std::vector<FeatureType> m_featureTypes;
+};
+
+Q_DECLARE_METATYPE(PackedGeometry)
+
+#endif // PACKEDGEOMETRY_H
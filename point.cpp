@@ -1,15 +1,11 @@
 #include "point.h"
-#include <QGraphicsSvgItem>
 #include "autonomousvehicleproject.h"
-#include <QSvgRenderer>
+#include "symbolatlas.h"
 
 Point::Point(MissionItem* parent):GeoGraphicsMissionItem(parent)
 {
-    QGraphicsSvgItem *symbol = new QGraphicsSvgItem(this);
-    symbol->setSharedRenderer(autonomousVehicleProject()->symbols());
-    symbol->setElementId("Square");
-    symbol->setFlag(QGraphicsItem::ItemIgnoresTransformations);
-
+    // the symbol is blitted from the project's atlas at a fixed screen size
+    setFlag(QGraphicsItem::ItemIgnoresTransformations);
 }
 
 void Point::updateProjectedPoints()
@@ -34,7 +30,8 @@ void Point::read(const QJsonObject& json)
 
 QRectF Point::boundingRect() const
 {
-    return childrenBoundingRect();
+    QSizeF size = autonomousVehicleProject()->symbolAtlas()->symbolSize("Square");
+    return QRectF(-size.width()/2.0,-size.height()/2.0,size.width(),size.height());
 }
 
 void Point::setLocation(QGeoCoordinate const &location)
@@ -46,4 +43,6 @@ void Point::setLocation(QGeoCoordinate const &location)
 
 void Point::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+    QPointF origin;
+    autonomousVehicleProject()->symbolAtlas()->draw(painter,"Square",&origin,1);
 }
@@ -20,11 +20,21 @@ void Polygon::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, Q
     p.setCosmetic(true);
     p.setWidth(2);
     painter->setPen(p);
-    if(m_exteriorRing.length() > 1)
-        painter->drawPolygon(m_exteriorPolygon);
+    int level = m_pyramid.levelFor(painter->worldTransform());
+    if(level >= 0)
+    {
+        for(int r = 0; r < m_pyramid.ringCount(); r++)
+            if(m_pyramid.ringSize(level,r) > 1)
+                painter->drawPolygon(m_pyramid.ring(level,r),m_pyramid.ringSize(level,r));
+    }
+    else
+    {
+        if(m_exteriorRing.length() > 1)
+            painter->drawPolygon(m_exteriorPolygon);
     
-    for(auto ip:m_interiorPolygons)
-        painter->drawPolygon(ip);
+        for(auto ip:m_interiorPolygons)
+            painter->drawPolygon(ip);
+    }
         
     painter->restore();
 }
@@ -89,25 +99,23 @@ QPainterPath Polygon::shape() const
 
 void Polygon::updateProjectedPoints()
 {
-    for(auto p: m_exteriorRing)
+    for(auto &p: m_exteriorRing)
         p.pos = geoToPixel(p.location,autonomousVehicleProject());
-    for(auto ir: m_interiorRings)
-        for(auto p: ir)
+    for(auto &ir: m_interiorRings)
+        for(auto &p: ir)
             p.pos = geoToPixel(p.location,autonomousVehicleProject());
     updateBBox();
 }
 
 void Polygon::updateBBox()
 {
+    prepareGeometryChange();
     if(m_exteriorRing.length() >0)
     {
         m_exteriorPolygon.clear();
-        m_bbox = QRectF(m_exteriorRing[0].pos,QSizeF());
         for(auto p:m_exteriorRing)
-        {
-            m_bbox = m_bbox.united(QRectF(p.pos,QSizeF()));
             m_exteriorPolygon << p.pos;
-        }
+        m_bbox = m_exteriorPolygon.boundingRect();
     }
     else
         m_bbox = QRectF();
@@ -120,6 +128,21 @@ void Polygon::updateBBox()
                 pf << p.pos;
             m_interiorPolygons.append(pf);
         }
+
+    std::vector<QPointF> points;
+    std::vector<int> ringOffsets;
+    if(m_exteriorRing.length() > 1)
+    {
+        ringOffsets.push_back(points.size());
+        points.insert(points.end(),m_exteriorPolygon.begin(),m_exteriorPolygon.end());
+    }
+    for(auto const &ip: m_interiorPolygons)
+    {
+        ringOffsets.push_back(points.size());
+        points.insert(points.end(),ip.begin(),ip.end());
+    }
+    ringOffsets.push_back(points.size());
+    m_pyramid.build(points.data(),ringOffsets);
 }
 
 void Polygon::addExteriorPoint(const QGeoCoordinate& location)
@@ -3,6 +3,7 @@
 
 #include "geographicsmissionitem.h"
 #include "locationposition.h"
+#include "simplificationpyramid.h"
 
 class Polygon : public GeoGraphicsMissionItem
 {
@@ -36,6 +37,7 @@ private:
     QList<QList<LocationPosition> > m_interiorRings;
     QList<QPolygonF> m_interiorPolygons;
     QRectF m_bbox;
+    SimplificationPyramid m_pyramid;
     
     
 };
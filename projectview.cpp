@@ -12,7 +12,9 @@
 #include "surveyarea.h"
 #include <QDebug>
 #include <QMenu>
+#include <QGraphicsRectItem>
 #include "measuringtool.h"
+#include "vectorlayer.h"
 
 #ifdef AMP_ROS
 #include "roslink.h"
@@ -20,7 +22,7 @@
 
 
 ProjectView::ProjectView(QWidget *parent) : QGraphicsView(parent),
-    statusBar(0), positionLabel(new QLabel()), modeLabel(new QLabel()), mouseMode(MouseMode::pan), currentTrackLine(nullptr), pendingTrackLineWaypoint(nullptr), pendingSurveyPattern(nullptr), pendingSurveyArea(nullptr),pendingSurveyAreaWaypoint(nullptr),measuringTool(nullptr)
+    statusBar(0), positionLabel(new QLabel()), modeLabel(new QLabel()), mouseMode(MouseMode::pan), currentTrackLine(nullptr), pendingTrackLineWaypoint(nullptr), pendingSurveyPattern(nullptr), pendingSurveyArea(nullptr),pendingSurveyAreaWaypoint(nullptr),measuringTool(nullptr),pendingArea(nullptr)
 {
 
     positionLabel->setText("(,)");
@@ -51,7 +53,7 @@ void ProjectView::mousePressEvent(QMouseEvent *event)
         case MouseMode::addWaypoint:
             if(bg)
             {
-                m_project->addWaypoint(bg->pixelToGeo(mapToScene(event->pos())));
+                m_project->addWaypoint(bg->pixelToGeo(snappedScenePosition(event)));
             }
             setPanMode();
             break;
@@ -61,12 +63,12 @@ void ProjectView::mousePressEvent(QMouseEvent *event)
                 if(bg)
                 {
                     currentTrackLine = m_project->addTrackLine(bg->pixelToGeo(mapToScene(event->pos())));
-                    pendingTrackLineWaypoint = currentTrackLine->addWaypoint(bg->pixelToGeo(mapToScene(event->pos())));
+                    pendingTrackLineWaypoint = currentTrackLine->addWaypoint(bg->pixelToGeo(snappedScenePosition(event)));
                 }
             }
             else
             {
-                pendingTrackLineWaypoint = currentTrackLine->addWaypoint(bg->pixelToGeo(mapToScene(event->pos())));
+                pendingTrackLineWaypoint = currentTrackLine->addWaypoint(bg->pixelToGeo(snappedScenePosition(event)));
 
             }
             break;
@@ -98,17 +100,27 @@ void ProjectView::mousePressEvent(QMouseEvent *event)
                 if(bg)
                 {
                     pendingSurveyArea = m_project->addSurveyArea(bg->pixelToGeo(mapToScene(event->pos())));
-                    pendingSurveyAreaWaypoint = pendingSurveyArea->addWaypoint(bg->pixelToGeo(mapToScene(event->pos())));
+                    pendingSurveyAreaWaypoint = pendingSurveyArea->addWaypoint(bg->pixelToGeo(snappedScenePosition(event)));
                 }
             }
             else
             {
-                pendingSurveyAreaWaypoint = pendingSurveyArea->addWaypoint(bg->pixelToGeo(mapToScene(event->pos())));
+                pendingSurveyAreaWaypoint = pendingSurveyArea->addWaypoint(bg->pixelToGeo(snappedScenePosition(event)));
             }
+            break;
+        case MouseMode::selectArea:
+            if(bg && !pendingArea)
+            {
+                pendingAreaStart = mapToScene(event->pos());
+                QPen p(Qt::DashLine);
+                p.setCosmetic(true);
+                pendingArea = scene()->addRect(QRectF(pendingAreaStart,pendingAreaStart),p);
+            }
+            break;
         }
         break;
     case Qt::RightButton:
-        if(mouseMode == MouseMode::addTrackline || mouseMode == MouseMode::addWaypoint || mouseMode == MouseMode::addSurveyPattern || mouseMode == MouseMode::addSurveyArea)
+        if(mouseMode == MouseMode::addTrackline || mouseMode == MouseMode::addWaypoint || mouseMode == MouseMode::addSurveyPattern || mouseMode == MouseMode::addSurveyArea || mouseMode == MouseMode::selectArea)
         {
             if(mouseMode == MouseMode::addTrackline && currentTrackLine)
             {
@@ -166,14 +178,16 @@ void ProjectView::mouseMoveEvent(QMouseEvent *event)
         }
         if(pendingTrackLineWaypoint)
         {
-            pendingTrackLineWaypoint->setLocation(bg->pixelToGeo(mapToScene(event->pos())));
+            pendingTrackLineWaypoint->setLocation(bg->pixelToGeo(snappedScenePosition(event)));
         }
         if(pendingSurveyAreaWaypoint)
         {
-            pendingSurveyAreaWaypoint->setLocation(bg->pixelToGeo(mapToScene(event->pos())));
+            pendingSurveyAreaWaypoint->setLocation(bg->pixelToGeo(snappedScenePosition(event)));
         }
         if(measuringTool)
             measuringTool->setFinish(llMouse);
+        if(pendingArea)
+            pendingArea->setRect(QRectF(pendingAreaStart,transformedMouse).normalized());
     }
     positionLabel->setText(posText);
     QGraphicsView::mouseMoveEvent(event);
@@ -187,9 +201,41 @@ void ProjectView::mouseReleaseEvent(QMouseEvent *event)
             delete measuringTool;
         measuringTool = nullptr;
     }
+    if(event->button() == Qt::LeftButton && pendingArea)
+    {
+        BackgroundRaster *bg = m_project->getBackgroundRaster();
+        QRectF box = pendingArea->rect();
+        QGeoRectangle area;
+        if(bg && !box.isEmpty())
+            area = QGeoRectangle(QList<QGeoCoordinate>() << bg->pixelToGeo(box.topLeft()) << bg->pixelToGeo(box.bottomRight()));
+        setPanMode();
+        if(area.isValid())
+            emit areaSelected(area);
+    }
     QGraphicsView::mouseReleaseEvent(event);
 }
 
+QPointF ProjectView::snappedScenePosition(QMouseEvent* event) const
+{
+    QPointF position = mapToScene(event->pos());
+    if(event->modifiers() & Qt::ShiftModifier)
+        return position;
+    qreal best = 8.0/matrix().m11();
+    QPointF ret = position;
+    for(auto layer: m_project->vectorLayers())
+    {
+        if(!layer->isVisible())
+            continue;
+        QPointF snapped;
+        if(layer->snap(layer->mapFromScene(position),best,snapped))
+        {
+            ret = layer->mapToScene(snapped);
+            best = QLineF(position,ret).length();
+        }
+    }
+    return ret;
+}
+
 void ProjectView::setAddWaypointMode()
 {
     setDragMode(NoDrag);
@@ -222,6 +268,14 @@ void ProjectView::setAddSurveyAreaMode()
     setCursor(Qt::CrossCursor);
 }
 
+void ProjectView::setSelectAreaMode()
+{
+    setDragMode(NoDrag);
+    mouseMode = MouseMode::selectArea;
+    modeLabel->setText("Mode: select area");
+    setCursor(Qt::CrossCursor);
+}
+
 void ProjectView::setStatusBar(QStatusBar *bar)
 {
     statusBar = bar;
@@ -243,6 +297,12 @@ void ProjectView::setPanMode()
     unsetCursor();
     pendingSurveyPattern = nullptr;
     currentTrackLine = nullptr;
+    if(pendingArea)
+    {
+        scene()->removeItem(pendingArea);
+        delete pendingArea;
+        pendingArea = nullptr;
+    }
 }
 
 void ProjectView::contextMenuEvent(QContextMenuEvent* event)
@@ -3,6 +3,7 @@
 
 #include<QGraphicsView>
 #include <QGeoCoordinate>
+#include <QGeoRectangle>
 
 class QStatusBar;
 class QLabel;
@@ -13,6 +14,7 @@ class SurveyArea;
 class Waypoint;
 class BackgroundRaster;
 class MeasuringTool;
+class QGraphicsRectItem;
 
 class ProjectView : public QGraphicsView
 {
@@ -24,11 +26,14 @@ public:
     void setAddTracklineMode();
     void setAddSurveyPatternMode();
     void setAddSurveyAreaMode();
+    /// Lets the user drag out a box, reported through areaSelected.
+    void setSelectAreaMode();
     void setPanMode();
     void setProject(AutonomousVehicleProject *project);
 signals:
     void currentChanged(QModelIndex &index);
     void scaleChanged(qreal scale);
+    void areaSelected(QGeoRectangle const &area);
 
 public slots:
 #ifdef AMP_ROS
@@ -46,7 +51,7 @@ protected:
     void contextMenuEvent(QContextMenuEvent *event) override;
 
 private:
-    enum class MouseMode {pan, addWaypoint, addTrackline, addSurveyPattern, addSurveyArea};
+    enum class MouseMode {pan, addWaypoint, addTrackline, addSurveyPattern, addSurveyArea, selectArea};
     QStatusBar * statusBar;
     QLabel * positionLabel;
     QLabel * modeLabel;
@@ -58,9 +63,15 @@ private:
     SurveyArea * pendingSurveyArea;
     Waypoint * pendingSurveyAreaWaypoint;
     MeasuringTool * measuringTool;
+    QGraphicsRectItem * pendingArea;
+    QPointF pendingAreaStart;
 
     QGeoCoordinate m_contextMenuLocation;
 
+    /// Scene position of the mouse, snapped to the nearest vertex or edge of a
+    /// visible vector layer within a few pixels unless Shift is held.
+    QPointF snappedScenePosition(QMouseEvent *event) const;
+
 };
 
 #endif // PROJECTVIEW_H
@@ -0,0 +1,60 @@
+#include "renderscheduler.h"
+#include <QTimer>
+#include <QtMath>
+
+RenderScheduler::RenderScheduler(QObject* parent, double frameRate):QObject(parent),m_timer(new QTimer(this)),m_frameRate(frameRate),m_pending(false)
+{
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &RenderScheduler::tick);
+    setFrameRate(frameRate);
+    resetStats();
+}
+
+double RenderScheduler::frameRate() const
+{
+    return m_frameRate;
+}
+
+void RenderScheduler::setFrameRate(double frameRate)
+{
+    m_frameRate = qMax(1.0,frameRate);
+    m_timer->setInterval(qMax(1,qRound(1000.0/m_frameRate)));
+}
+
+RenderScheduler::Stats const & RenderScheduler::stats() const
+{
+    return m_stats;
+}
+
+void RenderScheduler::resetStats()
+{
+    m_stats.requested = 0;
+    m_stats.applied = 0;
+}
+
+void RenderScheduler::requestFrame()
+{
+    m_stats.requested++;
+    if(m_timer->isActive())
+        m_pending = true;
+    else
+    {
+        applyFrame();
+        m_timer->start();
+    }
+}
+
+void RenderScheduler::tick()
+{
+    if(m_pending)
+        applyFrame();
+    else
+        m_timer->stop();
+}
+
+void RenderScheduler::applyFrame()
+{
+    m_pending = false;
+    m_stats.applied++;
+    emit frame();
+}
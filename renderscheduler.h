@@ -0,0 +1,52 @@
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QObject>
+
+class QTimer;
+
+/// Coalesces repaint requests from fast telemetry into at most one frame per
+/// display interval. A request while idle is served at once; requests made
+/// during the following interval are merged into a single frame at its end,
+/// and the timer stops once an interval passes without any.
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        quint64 requested;
+        quint64 applied;
+        /// Requests absorbed into another request's frame.
+        quint64 dropped() const {return requested-applied;}
+    };
+
+    explicit RenderScheduler(QObject *parent = nullptr, double frameRate = 30.0);
+
+    double frameRate() const;
+    void setFrameRate(double frameRate);
+
+    Stats const &stats() const;
+    void resetStats();
+
+public slots:
+    void requestFrame();
+
+signals:
+    /// Time to apply geometry changes and repaint.
+    void frame();
+
+private slots:
+    void tick();
+
+private:
+    QTimer *m_timer;
+    double m_frameRate;
+    bool m_pending;
+    Stats m_stats;
+
+    void applyFrame();
+};
+
+#endif // RENDERSCHEDULER_H
@@ -7,16 +7,70 @@
 #include "autonomousvehicleproject.h"
 #include "backgroundraster.h"
 #include <QTimer>
+#include <QThread>
+#include <QSet>
+#include <QtMath>
+#include <cstring>
 #include "gz4d_geo.h"
 #include "rosdetails.h"
+#include "renderscheduler.h"
+#include "roslinklayer.h"
+#include "ros/serialization.h"
+#include <chrono>
 
-ROSAISContact::ROSAISContact(QObject* parent): QObject(parent), mmsi(0), heading(0.0)
+
+namespace
 {
+    QList<QPainterPath> historyPaths(TrackHistory const &history)
+    {
+        QList<QPainterPath> ret;
+        for(int i = 0; i < history.pathCount(); i++)
+            ret.append(history.path(i));
+        return ret;
+    }
 
+    QPen cosmeticPen(QColor const &color, int width)
+    {
+        QPen ret(color);
+        ret.setCosmetic(true);
+        ret.setWidth(width);
+        return ret;
+    }
 }
 
+template<typename M> void ROSLink::addTopic(const std::string& name, void (ROSLink::*callback)(boost::shared_ptr<M const> const &))
+{
+    quint32 id = m_topics.size()+1;
+    Topic t;
+    t.name = name;
+    t.subscribe = [this,name,id,callback](ros::NodeHandle &node)
+    {
+        boost::function<void(boost::shared_ptr<M const> const &)> f = [this,id,callback](boost::shared_ptr<M const> const &message)
+        {
+            if(m_recorder.isOpen())
+            {
+                quint32 size = ros::serialization::serializationLength(*message);
+                std::vector<uint8_t> buffer(size);
+                ros::serialization::OStream stream(buffer.data(),size);
+                ros::serialization::serialize(stream,*message);
+                qint64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+                m_recorder.append(now,id,buffer.data(),size);
+            }
+            (this->*callback)(message);
+        };
+        return node.subscribe<M>(name,10,f);
+    };
+    t.replay = [this,callback](char const *data, quint32 size)
+    {
+        boost::shared_ptr<M> message(new M);
+        ros::serialization::IStream stream(reinterpret_cast<uint8_t*>(const_cast<char*>(data)),size);
+        ros::serialization::deserialize(stream,*message);
+        (this->*callback)(message);
+    };
+    m_topics.push_back(t);
+}
 
-ROSLink::ROSLink(AutonomousVehicleProject* parent): QObject(parent), GeoGraphicsItem(),m_node(nullptr), m_spinner(nullptr),m_have_local_reference(false),m_heading(0.0),m_posmv_heading(0.0),m_base_heading(0.0), m_active(false),m_helmMode("standby"),m_view_point_active(false),m_view_seglist_active(false),m_view_polygon_active(false),m_range(0.0),m_bearing(0.0)
+ROSLink::ROSLink(AutonomousVehicleProject* parent): QObject(parent), GeoGraphicsItem(),m_node(nullptr), m_spinner(nullptr),m_location_history(500),m_posmv_location_history(1500),m_base_location_history(100),m_have_local_reference(false),m_heading(0.0),m_posmv_heading(0.0),m_base_heading(0.0), m_active(false),m_helmMode("standby"),m_glyphs([this](QGeoCoordinate const &l){return geoToPixel(l,autonomousVehicleProject());}),m_view_point_active(false),m_view_seglist_active(false),m_view_polygon_active(false),m_range(0.0),m_bearing(0.0),m_dirty_layers(0),m_in_frame(false)
 {
     setAcceptHoverEvents(false);
     setOpacity(1.0);
@@ -32,6 +86,118 @@ ROSLink::ROSLink(AutonomousVehicleProject* parent): QObject(parent), GeoGraphics
     
     m_watchdog_timer = new QTimer(this);
     connect(m_watchdog_timer, SIGNAL(timeout()), this, SLOT(watchdogUpdate()));
+
+    m_render_scheduler = new RenderScheduler(this);
+    connect(m_render_scheduler, &RenderScheduler::frame, this, &ROSLink::updateFrame);
+    connect(parent, &AutonomousVehicleProject::mapScaleChanged, this, &ROSLink::updateMapScale);
+
+    m_depth_grid = new DepthGrid();
+    m_depth_grid_thread = new QThread();
+    m_depth_grid->moveToThread(m_depth_grid_thread);
+    connect(m_depth_grid, &DepthGrid::updated, this, &ROSLink::depthGridUpdated);
+    m_depth_grid_thread->start();
+
+    addTopic("/udp/position", &ROSLink::geoPointStampedCallback);
+    addTopic("/base/position", &ROSLink::baseNavSatFixCallback);
+    addTopic("/udp/origin", &ROSLink::originCallback);
+    addTopic("/udp/heading", &ROSLink::headingCallback);
+    addTopic("/base/orientation", &ROSLink::baseHeadingCallback);
+    addTopic("/udp/contact", &ROSLink::contactCallback);
+    addTopic("/udp/heartbeat", &ROSLink::heartbeatCallback);
+    addTopic("/udp/view_point", &ROSLink::viewPointCallback);
+    addTopic("/udp/view_polygon", &ROSLink::viewPolygonCallback);
+    addTopic("/udp/view_seglist", &ROSLink::viewSeglistCallback);
+    addTopic("/udp/posmv/position", &ROSLink::posmvPositionCallback);
+    addTopic("/udp/posmv/orientation", &ROSLink::posmvOrientationCallback);
+    addTopic("/range", &ROSLink::rangeCallback);
+    addTopic("/bearing", &ROSLink::bearingCallback);
+    addTopic("/udp/sog", &ROSLink::sogCallback);
+    addTopic("/udp/coverage", &ROSLink::coverageCallback);
+    addTopic("/udp/mbes_ping", &ROSLink::pingCallback);
+    addTopic("/udp/project11/mission_manager/current_path", &ROSLink::currentPathCallback);
+    m_replay = new TelemetryReplay(this);
+    connect(m_replay, &TelemetryReplay::finished, this, &ROSLink::replayFinished);
+    m_replay_time = 0;
+
+    // in drawing order
+    setFlag(QGraphicsItem::ItemHasNoContents);
+    m_coverage_layer = new ROSLinkLayer(this);
+    m_coverage_layer->setPens(QList<QPen>() << cosmeticPen(Qt::green,4));
+    m_coverage_layer->setBrush(Qt::cyan);
+    m_pings_layer = new ROSLinkRasterLayer(this);
+    m_ais_layer = new ROSLinkLayer(this);
+    m_ais_layer->setPens(QList<QPen>() << cosmeticPen(Qt::blue,2));
+    m_view_layer = new ROSLinkLayer(this);
+    m_view_layer->setPens(QList<QPen>() << cosmeticPen(Qt::darkYellow,4));
+    m_current_path_layer = new ROSLinkLayer(this);
+    m_current_path_layer->setPens(QList<QPen>() << cosmeticPen(Qt::darkYellow,4));
+    m_base_layer = new ROSLinkLayer(this);
+    m_base_layer->setPens(QList<QPen>() << cosmeticPen(Qt::darkBlue,5) << cosmeticPen(Qt::lightGray,3));
+    m_posmv_layer = new ROSLinkLayer(this);
+    m_vehicle_layer = new ROSLinkLayer(this);
+}
+
+ROSLink::~ROSLink()
+{
+    // the replay thread calls into this object
+    m_replay->stop();
+    m_recorder.close();
+    m_depth_grid_thread->quit();
+    m_depth_grid_thread->wait();
+    delete m_depth_grid;
+    delete m_depth_grid_thread;
+}
+
+bool ROSLink::startRecording(const QString& path)
+{
+    QStringList names;
+    for(auto const &t: m_topics)
+        names << QString::fromStdString(t.name);
+    return m_recorder.open(path,names);
+}
+
+void ROSLink::stopRecording()
+{
+    m_recorder.close();
+}
+
+bool ROSLink::recording() const
+{
+    return m_recorder.isOpen();
+}
+
+bool ROSLink::startReplay(const QString& path, double speed)
+{
+    // replayed and live messages would both write state meant for one thread
+    if(m_node)
+        return false;
+    // the handlers read ros::Time, which needs no master
+    ros::Time::init();
+    QHash<QString, int> topics;
+    for(int i = 0; i < int(m_topics.size()); i++)
+        topics[QString::fromStdString(m_topics[i].name)] = i;
+    m_replay_time = 0;
+    bool ok = m_replay->start(path,speed,[this,topics](qint64 time, QString const &topic, char const *data, quint32 size)
+    {
+        m_replay_time = time;
+        auto t = topics.find(topic);
+        if(t != topics.end())
+            m_topics[t.value()].replay(data,size);
+    });
+    // contacts still age, on the log's clock
+    if(ok)
+        m_watchdog_timer->start(500);
+    return ok;
+}
+
+void ROSLink::stopReplay()
+{
+    m_replay->stop();
+}
+
+bool ROSLink::replaying() const
+{
+    return m_replay->isRunning();
 }
 
 void ROSLink::connectROS()
@@ -40,26 +206,13 @@ void ROSLink::connectROS()
     {
         if(!m_node)
         {
+            // live data takes over from a replay
+            m_replay->stop();
+            m_replay_time = 0;
             m_node = new ros::NodeHandle;
             m_spinner = new ros::AsyncSpinner(0);
-            m_geopoint_subscriber = m_node->subscribe("/udp/position", 10, &ROSLink::geoPointStampedCallback, this);
-            m_base_navsatfix_subscriber = m_node->subscribe("/base/position", 10, &ROSLink::baseNavSatFixCallback, this);
-            m_origin_subscriber = m_node->subscribe("/udp/origin", 10, &ROSLink::originCallback, this);
-            m_heading_subscriber = m_node->subscribe("/udp/heading", 10, &ROSLink::headingCallback, this);
-            m_base_heading_subscriber = m_node->subscribe("/base/orientation", 10, &ROSLink::baseHeadingCallback, this);
-            m_ais_subscriber = m_node->subscribe("/udp/contact", 10, &ROSLink::contactCallback, this);
-            m_heartbeat_subscriber = m_node->subscribe("/udp/heartbeat", 10, &ROSLink::heartbeatCallback, this);
-            m_view_point_subscriber = m_node->subscribe("/udp/view_point", 10, &ROSLink::viewPointCallback, this);
-            m_view_polygon_subscriber = m_node->subscribe("/udp/view_polygon", 10, &ROSLink::viewPolygonCallback, this);
-            m_view_seglist_subscriber = m_node->subscribe("/udp/view_seglist", 10, &ROSLink::viewSeglistCallback, this);
-            m_posmv_position = m_node->subscribe("/udp/posmv/position", 10, &ROSLink::posmvPositionCallback, this);
-            m_posmv_orientation = m_node->subscribe("/udp/posmv/orientation", 10, &ROSLink::posmvOrientationCallback, this);
-            m_range_subscriber = m_node->subscribe("/range", 10, &ROSLink::rangeCallback, this);
-            m_bearing_subscriber = m_node->subscribe("/bearing",10, &ROSLink::bearingCallback, this);
-            m_sog_subscriber = m_node->subscribe("/udp/sog",10, &ROSLink::sogCallback, this);
-            m_coverage_subscriber = m_node->subscribe("/udp/coverage", 10, &ROSLink::coverageCallback, this);
-            m_ping_subscriber = m_node->subscribe("/udp/mbes_ping", 10, &ROSLink::pingCallback, this);
-            m_current_path_subscriber = m_node->subscribe("/udp/project11/mission_manager/current_path", 10, &ROSLink::currentPathCallback, this);
+            for(auto const &t: m_topics)
+                m_subscribers.push_back(t.subscribe(*m_node));
             
             //m_active_publisher = m_node->advertise<std_msgs::Bool>("/udp/active",1);
             //m_helmMode_publisher = m_node->advertise<std_msgs::String>("/udp/helm_mode",1);
@@ -69,6 +222,7 @@ void ROSLink::connectROS()
             m_send_command_publisher = m_node->advertise<std_msgs::String>("/send_command",1);
             m_spinner->start();
             m_watchdog_timer->start(500);
+            requestFrame(VehicleLayer|PosmvLayer);
             emit rosConnected(true);
         }
     }
@@ -76,10 +230,13 @@ void ROSLink::connectROS()
     {
         if(m_node)
         {
+            stopAdaptiveSpacing();
+            m_subscribers.clear();
             delete m_node;
             m_node = nullptr;
             delete m_spinner;
             m_spinner = nullptr;
+            requestFrame(VehicleLayer|PosmvLayer);
             emit rosConnected(false);
         }
     }
@@ -88,100 +245,142 @@ void ROSLink::connectROS()
 
 QRectF ROSLink::boundingRect() const
 {
-    return shape().boundingRect();
+    return QRectF();
 }
 
 void ROSLink::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
-    painter->save();
+    // the layers paint themselves
+}
 
-    QPen p;
-    p.setCosmetic(true);
+void ROSLink::requestFrame(int layers)
+{
+    m_dirty_layers |= layers;
+    if(!m_in_frame)
+        m_render_scheduler->requestFrame();
+}
 
-    
-    p.setColor(Qt::green);
-    p.setWidth(4);
-    painter->setPen(p);
-    painter->setBrush(Qt::cyan);
-    painter->drawPath(coverageShape());
-    //painter->drawPath(pingsShape());
-    painter->setBrush(Qt::NoBrush);
+void ROSLink::updateFrame()
+{
+    // telemetry applied here lands in this frame
+    m_in_frame = true;
+    drainTelemetry();
+    m_in_frame = false;
+    renderFrame();
+}
 
+void ROSLink::pushTelemetry(const TelemetryRecord& record)
+{
+    m_telemetry.push(record);
+    wakeTelemetry();
+}
 
-    
-    p.setColor(Qt::blue);
-    p.setWidth(2);
-    painter->setPen(p);
-    painter->drawPath(aisShape());
-    
-    p.setColor(Qt::darkYellow);
-    p.setWidth(4);
-    painter->setPen(p);
-    painter->drawPath(viewShape());
-    painter->drawPath(currentPathShape());
-
-    p.setColor(Qt::darkBlue);
-    p.setWidth(5);
-    painter->setPen(p);
-    painter->drawPath(baseShape());
-    p.setWidth(3);
-    p.setColor(Qt::lightGray);
-    painter->setPen(p);
-    painter->drawPath(baseShape());
-
-   
-    p.setWidth(8);
-    p.setColor(Qt::yellow);
-    painter->setPen(p);
-    painter->drawPath(vehicleShapePosmv());
-    p.setWidth(3);
-    if(m_node)
-        p.setColor(Qt::darkGreen);
-    else
-        p.setColor(Qt::darkRed);
-    painter->setPen(p);
-    painter->drawPath(vehicleShapePosmv());
+void ROSLink::wakeTelemetry()
+{
+    if(m_telemetry.markPending())
+        QMetaObject::invokeMethod(m_render_scheduler,"requestFrame", Qt::QueuedConnection);
+}
 
-    if(m_node)
-        p.setColor(Qt::darkGreen);
-    else
-        p.setColor(Qt::darkRed);
-    p.setWidth(3);
-    painter->setPen(p);
-    painter->drawPath(vehicleShape());
+void ROSLink::drainTelemetry()
+{
+    m_telemetry.startDrain();
+    double a, b, c;
+    // the origin first, so the positions below are placed from it
+    if(m_telemetry.takeState(TelemetryQueue::Origin,a,b,c))
+    {
+        QGeoCoordinate origin(a,b,c);
+        // soundings are binned relative to the origin
+        if(m_origin.isValid() && origin != m_origin)
+            QMetaObject::invokeMethod(m_depth_grid,"clear", Qt::QueuedConnection);
+        m_origin = origin;
+        updateOriginLocation(m_origin);
+    }
+    TelemetryRecord record;
+    while(m_telemetry.pop(record))
+    {
+        QGeoCoordinate position(record.latitude,record.longitude,record.altitude);
+        switch(record.topic)
+        {
+        case TelemetryRecord::Location:
+            updateLocation(position);
+            break;
+        case TelemetryRecord::PosmvLocation:
+            updatePosmvLocation(position);
+            break;
+        case TelemetryRecord::BaseLocation:
+            updateBaseLocation(position);
+            break;
+        case TelemetryRecord::AISContact:
+            addAISContact(record.contact);
+            break;
+        }
+    }
+    if(m_telemetry.takeState(TelemetryQueue::Heading,a,b,c))
+        updateHeading(a);
+    if(m_telemetry.takeState(TelemetryQueue::PosmvHeading,a,b,c))
+        updatePosmvHeading(a);
+    if(m_telemetry.takeState(TelemetryQueue::BaseHeading,a,b,c))
+        updateBaseHeading(a);
+    if(m_telemetry.takeState(TelemetryQueue::Sog,a,b,c))
+        updateSog(a);
+}
+
+void ROSLink::renderFrame()
+{
+    // room for the widest cosmetic pen
+    qreal margin = 0.0;
+    auto bgr = autonomousVehicleProject()->getBackgroundRaster();
+    if(bgr)
+        margin = 8.0/bgr->mapScale();
+    QColor status = m_node ? Qt::darkGreen : Qt::darkRed;
+
+    if(m_dirty_layers & VehicleLayer)
+    {
+        m_vehicle_layer->setPens(QList<QPen>() << cosmeticPen(status,3));
+        m_vehicle_layer->setPaths(historyPaths(m_location_history) << vehicleShape(),margin);
+    }
+    if(m_dirty_layers & PosmvLayer)
+    {
+        m_posmv_layer->setPens(QList<QPen>() << cosmeticPen(Qt::yellow,8) << cosmeticPen(status,3));
+        m_posmv_layer->setPaths(historyPaths(m_posmv_location_history) << vehicleShapePosmv(),margin);
+    }
+    if(m_dirty_layers & BaseLayer)
+        m_base_layer->setPaths(historyPaths(m_base_location_history) << baseShape(),margin);
+    if(m_dirty_layers & AISLayer)
+        m_ais_layer->setPaths(QList<QPainterPath>() << aisShape(),margin);
+    if(m_dirty_layers & ViewLayer)
+        m_view_layer->setPaths(QList<QPainterPath>() << viewShape(),margin);
+    if(m_dirty_layers & CurrentPathLayer)
+        m_current_path_layer->setPaths(QList<QPainterPath>() << currentPathShape(),margin);
+    if(m_dirty_layers & CoverageLayer)
+        m_coverage_layer->setPaths(QList<QPainterPath>() << coverageShape(),margin);
+    if(m_dirty_layers & PingsLayer)
+        m_pings_layer->setTiles(depthTiles());
+    m_dirty_layers = 0;
+}
 
-    painter->restore();
+void ROSLink::updateMapScale(qreal scale)
+{
+    // symbol sizes and pen margins follow the zoom
+    requestFrame(AllLayers);
 }
 
-QPainterPath ROSLink::shape() const
+void ROSLink::setRenderFrameRate(double frameRate)
 {
-    QPainterPath ret;
-    ret.addPath(vehicleShape());
-    ret.addPath(aisShape());
-    ret.addPath(viewShape());
-    ret.addPath(baseShape());
-    ret.addPath(coverageShape());
-    ret.addPath(pingsShape());
-    ret.addPath(currentPathShape());
-    return ret;
+    m_render_scheduler->setFrameRate(frameRate);
+}
+
+RenderScheduler::Stats const & ROSLink::renderStats() const
+{
+    return m_render_scheduler->stats();
 }
 
 QPainterPath ROSLink::vehicleShape() const
 {
     auto bgr = autonomousVehicleProject()->getBackgroundRaster();
     QPainterPath ret;
-    if (m_local_location_history.size() > 1)
+    if (m_location_history.size() > 1)
     {
-        auto p = m_local_location_history.begin();
-        ret.moveTo(*p);
-        p++;
-        while(p != m_local_location_history.end())
-        {
-            ret.lineTo(*p);
-            p++;
-        }
-        auto last = *(m_local_location_history.rbegin());
-        
         if(bgr)
         {
             qreal pixel_size = bgr->scaledPixelSize();
@@ -200,18 +399,8 @@ QPainterPath ROSLink::vehicleShape() const
 QPainterPath ROSLink::vehicleShapePosmv() const
 {
     QPainterPath ret;
-    if (m_local_posmv_location_history.size() > 1)
+    if (m_posmv_location_history.size() > 1)
     {
-        auto p = m_local_posmv_location_history.begin();
-        ret.moveTo(*p);
-        p++;
-        while(p != m_local_posmv_location_history.end())
-        {
-            ret.lineTo(*p);
-            p++;
-        }
-        auto last = *(m_local_posmv_location_history.rbegin());
-        
         auto bgr = autonomousVehicleProject()->getBackgroundRaster();
         if(bgr)
         {
@@ -229,18 +418,8 @@ QPainterPath ROSLink::vehicleShapePosmv() const
 QPainterPath ROSLink::baseShape() const
 {
     QPainterPath ret;
-    if (m_local_base_location_history.size() > 1)
+    if (m_base_location_history.size() > 1)
     {
-        auto p = m_local_base_location_history.begin();
-        ret.moveTo(*p);
-        p++;
-        while(p != m_local_base_location_history.end())
-        {
-            ret.lineTo(*p);
-            p++;
-        }
-        auto last = *(m_local_base_location_history.rbegin());
-        
         auto bgr = autonomousVehicleProject()->getBackgroundRaster();
         if(bgr)
         {
@@ -260,28 +439,26 @@ QPainterPath ROSLink::baseShape() const
 QPainterPath ROSLink::aisShape() const
 {
     QPainterPath ret;
-    for(auto contactList: m_contacts)
+    double now = this->now().toSec();
+    auto bgr = autonomousVehicleProject()->getBackgroundRaster();
+    for(int i = 0; i < m_contacts.vesselCount(); i++)
     {
-        if((ros::Time::now() - contactList.second.back()->timestamp) < ros::Duration(300))
+        AISContactStore::Vessel const &v = m_contacts.vessel(i);
+        AISContactStore::Position const &last = v.latest();
+        if(now - last.timestamp < 300)
         {
-            auto p = contactList.second.begin();
-            ret.moveTo((*p)->location_local);
-            p++;
-            while(p != contactList.second.end())
-            {
-                ret.lineTo((*p)->location_local);
-                p++;
-            }
-            auto last = *(contactList.second.rbegin());
+            ret.moveTo(v.position(0).local);
+            for(int j = 1; j < v.positionCount(); j++)
+                ret.lineTo(v.position(j).local);
 
-            auto bgr = autonomousVehicleProject()->getBackgroundRaster();
             if(bgr)
             {
+                QGeoCoordinate location(last.latitude,last.longitude);
                 qreal pixel_size = bgr->scaledPixelSize();
                 if(pixel_size > 1)
-                    drawTriangle(ret,last->location,last->heading,pixel_size);
+                    drawTriangle(ret,location,last.heading,pixel_size);
                 else
-                    drawShipOutline(ret,last->location,last->heading,last->dimension_to_bow,last->dimension_to_port,last->dimension_to_stbd,last->dimension_to_stern);
+                    drawShipOutline(ret,location,last.heading,v.dimension_to_bow,v.dimension_to_port,v.dimension_to_stbd,v.dimension_to_stern);
             }
         }
     }
@@ -354,101 +531,64 @@ QPainterPath ROSLink::currentPathShape() const
 
 QPainterPath ROSLink::coverageShape() const
 {
-    QPainterPath ret;
-    for(auto p: m_local_coverage)
-        ret.addPolygon(p);
-//     QPolygonF poly;
-//     if(!m_local_coverage.empty())
-//     {
-//         auto p = m_local_coverage.begin();
-//         poly << *p;
-//         //ret.moveTo(*p);
-//         p++;
-//         while(p != m_local_coverage.end())
-//         {
-//             poly << *p;
-//             //ret.lineTo(*p);
-//             p++;
-//         }
-//         ret.addPolygon(poly);
-//         //ret.lineTo(m_local_coverage.front());
-//     }
-    
-    return ret;
+    return m_coverage_path;
 }
 
-QPainterPath ROSLink::pingsShape() const
+QList<ROSLinkRasterLayer::Tile> ROSLink::depthTiles() const
 {
-    QPainterPath ret;
-    QPolygonF poly;
-    for(auto p: m_local_pings)
-        if(!p.empty())
+    QList<ROSLinkRasterLayer::Tile> ret;
+    auto bgr = autonomousVehicleProject()->getBackgroundRaster();
+    if(!bgr || !m_origin.isValid())
+        return ret;
+    // Cells of about a screen pixel or more. Where those tiles were evicted,
+    // the finest coarser tile left fills in underneath.
+    int level = m_depth_grid->levelFor(bgr->scaledPixelSize());
+    // tiles of the current level already hidden by finer ones
+    QSet<QPair<int,int> > covered;
+    for(; level < m_depth_grid->levelCount(); level++)
+    {
+        double size = m_depth_grid->cellSize(level)*DepthGrid::tileSize;
+        QList<ROSLinkRasterLayer::Tile> levelTiles;
+        for(auto const &t: m_depth_grid->tiles(level))
         {
-            auto pp = p.begin();
-            poly << *pp;
-            //ret.moveTo(*p);
-            pp++;
-            while(pp != p.end())
-            {
-                poly << *pp;
-                //ret.lineTo(*p);
-                pp++;
-            }
-            ret.addPolygon(poly);
-            //ret.lineTo(m_local_coverage.front());
+            QPair<int,int> key(qRound(t.extent.left()/size),qRound(t.extent.top()/size));
+            if(covered.contains(key))
+                continue;
+            covered.insert(key);
+            QPointF nw = geoToPixel(rosMapToGeo(QPointF(t.extent.left(),t.extent.bottom())),autonomousVehicleProject());
+            QPointF ne = geoToPixel(rosMapToGeo(QPointF(t.extent.right(),t.extent.bottom())),autonomousVehicleProject());
+            QPointF sw = geoToPixel(rosMapToGeo(QPointF(t.extent.left(),t.extent.top())),autonomousVehicleProject());
+            QPointF x = (ne-nw)/t.image.width();
+            QPointF y = (sw-nw)/t.image.height();
+            ROSLinkRasterLayer::Tile tile;
+            tile.image = t.image;
+            tile.transform = QTransform(x.x(),x.y(),y.x(),y.y(),nw.x(),nw.y());
+            levelTiles.append(tile);
         }
-    
+        // coarser tiles are drawn first so finer ones paint over them
+        ret = levelTiles+ret;
+
+        // a tile of the next level is hidden once all four of its quarters are
+        QHash<QPair<int,int>,int> quarters;
+        for(auto const &key: covered)
+            quarters[qMakePair(qFloor(key.first/2.0),qFloor(key.second/2.0))]++;
+        covered.clear();
+        for(auto q = quarters.cbegin(); q != quarters.cend(); ++q)
+            if(q.value() == 4)
+                covered.insert(q.key());
+    }
     return ret;
 }
 
 
 void ROSLink::drawTriangle(QPainterPath& path, const QGeoCoordinate& location, double heading_degrees, double scale) const
 {
-    QGeoCoordinate tip = location.atDistanceAndAzimuth(15*scale,heading_degrees);
-    QGeoCoordinate llcorner = location.atDistanceAndAzimuth(15*scale,heading_degrees-150);
-    QGeoCoordinate lrcorner = location.atDistanceAndAzimuth(15*scale,heading_degrees+150);
-
-//     QPointF ltip = geoToPixel(tip,autonomousVehicleProject())-m_local_reference_position;
-//     QPointF lllocal = geoToPixel(llcorner,autonomousVehicleProject())-m_local_reference_position;
-//     QPointF lrlocal = geoToPixel(lrcorner,autonomousVehicleProject())-m_local_reference_position;
-    QPointF ltip = geoToPixel(tip,autonomousVehicleProject());
-    QPointF lllocal = geoToPixel(llcorner,autonomousVehicleProject());
-    QPointF lrlocal = geoToPixel(lrcorner,autonomousVehicleProject());
-
-    path.moveTo(ltip);
-    path.lineTo(lllocal);
-    path.lineTo(lrlocal);
-    path.lineTo(ltip);
+    m_glyphs.addTriangle(path,location,heading_degrees,scale);
 }
 
 void ROSLink::drawShipOutline(QPainterPath& path, const QGeoCoordinate& location, double heading_degrees, float dimension_to_bow, float dimension_to_port, float dimension_to_stbd, float dimension_to_stern) const
 {
-        float length = dimension_to_bow+dimension_to_stern;
-        float width = dimension_to_port+dimension_to_stbd;
-        QGeoCoordinate llcorner = location.atDistanceAndAzimuth(dimension_to_port,270+heading_degrees).atDistanceAndAzimuth(dimension_to_stern,180+heading_degrees);
-        QGeoCoordinate lrcorner = llcorner.atDistanceAndAzimuth(width,90+heading_degrees);
-        QGeoCoordinate urcorner = lrcorner.atDistanceAndAzimuth(length,heading_degrees);
-        QGeoCoordinate ulcorner = urcorner.atDistanceAndAzimuth(width,270+heading_degrees);
-        QGeoCoordinate rkink = lrcorner.atDistanceAndAzimuth(length*.8,heading_degrees);
-        QGeoCoordinate lkink = llcorner.atDistanceAndAzimuth(length*.8,heading_degrees);
-        QGeoCoordinate bow = ulcorner.atDistanceAndAzimuth(width/2.0,90+heading_degrees);
-//         QPointF lllocal = geoToPixel(llcorner,autonomousVehicleProject())-m_local_reference_position;
-//         QPointF lrlocal = geoToPixel(lrcorner,autonomousVehicleProject())-m_local_reference_position;
-//         QPointF lkinkl = geoToPixel(lkink,autonomousVehicleProject())-m_local_reference_position;
-//         QPointF rkinkl = geoToPixel(rkink,autonomousVehicleProject())-m_local_reference_position;
-//         QPointF bowl = geoToPixel(bow,autonomousVehicleProject())-m_local_reference_position;
-        QPointF lllocal = geoToPixel(llcorner,autonomousVehicleProject());
-        QPointF lrlocal = geoToPixel(lrcorner,autonomousVehicleProject());
-        QPointF lkinkl = geoToPixel(lkink,autonomousVehicleProject());
-        QPointF rkinkl = geoToPixel(rkink,autonomousVehicleProject());
-        QPointF bowl = geoToPixel(bow,autonomousVehicleProject());
-        
-        path.moveTo(lllocal);
-        path.lineTo(lrlocal);
-        path.lineTo(rkinkl);
-        path.lineTo(bowl);
-        path.lineTo(lkinkl);
-        path.lineTo(lllocal);
+    m_glyphs.addShipOutline(path,location,heading_degrees,dimension_to_bow,dimension_to_port,dimension_to_stbd,dimension_to_stern);
 }
 
 
@@ -468,14 +608,22 @@ void ROSLink::setROSDetails(ROSDetails* details)
 
 void ROSLink::geoPointStampedCallback(const geographic_msgs::GeoPointStamped::ConstPtr& message)
 {
-    QGeoCoordinate position(message->position.latitude,message->position.longitude,message->position.altitude);
-    QMetaObject::invokeMethod(this,"updateLocation", Qt::QueuedConnection, Q_ARG(QGeoCoordinate, position));
+    TelemetryRecord record;
+    record.topic = TelemetryRecord::Location;
+    record.latitude = message->position.latitude;
+    record.longitude = message->position.longitude;
+    record.altitude = message->position.altitude;
+    pushTelemetry(record);
 }
 
 void ROSLink::posmvPositionCallback(const sensor_msgs::NavSatFix::ConstPtr& message)
 {
-    QGeoCoordinate position(message->latitude, message->longitude, message->altitude);
-    QMetaObject::invokeMethod(this,"updatePosmvLocation", Qt::QueuedConnection, Q_ARG(QGeoCoordinate, position));
+    TelemetryRecord record;
+    record.topic = TelemetryRecord::PosmvLocation;
+    record.latitude = message->latitude;
+    record.longitude = message->longitude;
+    record.altitude = message->altitude;
+    pushTelemetry(record);
 }
 
 void ROSLink::rangeCallback(const std_msgs::Float32::ConstPtr& message)
@@ -493,7 +641,8 @@ void ROSLink::bearingCallback(const std_msgs::Float32::ConstPtr& message)
 void ROSLink::sogCallback(const geometry_msgs::TwistStamped::ConstPtr& message)
 {
     qreal sog = sqrt(message->twist.linear.x*message->twist.linear.x+message->twist.linear.y*message->twist.linear.y);
-    QMetaObject::invokeMethod(this,"updateSog", Qt::QueuedConnection, Q_ARG(qreal, sog));  
+    m_telemetry.setState(TelemetryQueue::Sog,sog);
+    wakeTelemetry();
 }
 
 void ROSLink::updateSog(qreal sog)
@@ -514,32 +663,36 @@ void ROSLink::updateSog(qreal sog)
 
 void ROSLink::baseNavSatFixCallback(const sensor_msgs::NavSatFix::ConstPtr& message)
 {
-    QGeoCoordinate position(message->latitude, message->longitude, message->altitude);
-    QMetaObject::invokeMethod(this,"updateBaseLocation", Qt::QueuedConnection, Q_ARG(QGeoCoordinate, position));
+    TelemetryRecord record;
+    record.topic = TelemetryRecord::BaseLocation;
+    record.latitude = message->latitude;
+    record.longitude = message->longitude;
+    record.altitude = message->altitude;
+    pushTelemetry(record);
 }
 
 void ROSLink::originCallback(const geographic_msgs::GeoPoint::ConstPtr& message)
 {
-    m_origin.setLatitude(message->latitude);
-    m_origin.setLongitude(message->longitude);
-    m_origin.setAltitude(message->altitude);
-    QMetaObject::invokeMethod(this,"updateOriginLocation", Qt::QueuedConnection, Q_ARG(QGeoCoordinate, m_origin));
-    //qDebug() << m_origin;
+    m_telemetry.setState(TelemetryQueue::Origin,message->latitude,message->longitude,message->altitude);
+    wakeTelemetry();
 }
 
 void ROSLink::headingCallback(const marine_msgs::NavEulerStamped::ConstPtr& message)
 {
-    QMetaObject::invokeMethod(this,"updateHeading", Qt::QueuedConnection, Q_ARG(double, message->orientation.heading));
+    m_telemetry.setState(TelemetryQueue::Heading,message->orientation.heading);
+    wakeTelemetry();
 }
 
 void ROSLink::posmvOrientationCallback(const marine_msgs::NavEulerStamped::ConstPtr& message)
 {
-    QMetaObject::invokeMethod(this,"updatePosmvHeading", Qt::QueuedConnection, Q_ARG(double, message->orientation.heading));
+    m_telemetry.setState(TelemetryQueue::PosmvHeading,message->orientation.heading);
+    wakeTelemetry();
 }
 
 void ROSLink::baseHeadingCallback(const marine_msgs::NavEulerStamped::ConstPtr& message)
 {
-    QMetaObject::invokeMethod(this,"updateBaseHeading", Qt::QueuedConnection, Q_ARG(double, message->orientation.heading));
+    m_telemetry.setState(TelemetryQueue::BaseHeading,message->orientation.heading);
+    wakeTelemetry();
 }
 
 
@@ -549,21 +702,24 @@ void ROSLink::contactCallback(const marine_msgs::Contact::ConstPtr& message)
     qDebug() << "\t\t" << message->position.latitude << ", " << message->position.longitude;
     if(message->position.latitude > 90 || message->position.longitude > 180)
         return;
-    ROSAISContact *c = new ROSAISContact();
-    c->timestamp = message->header.stamp;
-    c->mmsi = message->mmsi;
-    c->name = message->name;
-    c->location.setLatitude(message->position.latitude);
-    c->location.setLongitude(message->position.longitude);
+    TelemetryRecord record;
+    record.topic = TelemetryRecord::AISContact;
+    AISContactReport &c = record.contact;
+    c.timestamp = message->header.stamp.toSec();
+    c.mmsi = message->mmsi;
+    strncpy(c.name,message->name.c_str(),sizeof(c.name)-1);
+    c.name[sizeof(c.name)-1] = 0;
+    c.latitude = message->position.latitude;
+    c.longitude = message->position.longitude;
     if(message->heading < 0)
-        c->heading = message->cog*180.0/M_PI;
+        c.heading = message->cog*180.0/M_PI;
     else
-        c->heading = message->heading*180.0/M_PI;
-    c->dimension_to_bow = message->dimension_to_bow;
-    c->dimension_to_port = message->dimension_to_port;
-    c->dimension_to_stbd = message->dimension_to_stbd;
-    c->dimension_to_stern = message->dimension_to_stern;
-    QMetaObject::invokeMethod(this,"addAISContact", Qt::QueuedConnection, Q_ARG(ROSAISContact*, c));
+        c.heading = message->heading*180.0/M_PI;
+    c.dimension_to_bow = message->dimension_to_bow;
+    c.dimension_to_port = message->dimension_to_port;
+    c.dimension_to_stbd = message->dimension_to_stbd;
+    c.dimension_to_stern = message->dimension_to_stern;
+    pushTelemetry(record);
 }
 
 void ROSLink::heartbeatCallback(const marine_msgs::Heartbeat::ConstPtr& message)
@@ -604,6 +760,9 @@ void ROSLink::watchdogUpdate()
     }
     else
         m_details->heartbeatDelay(1000.0);
+    // contacts go quiet without an update of their own
+    m_contacts.expire(now().toSec(),600);
+    requestFrame(AISLayer);
 }
 
 
@@ -646,6 +805,8 @@ void ROSLink::sendWaypoints(const QList<QGeoCoordinate>& waypoints)
 
 void ROSLink::sendMissionPlan(const QString& plan)
 {
+    // the plan replaces whatever adaptive spacing was driving
+    stopAdaptiveSpacing();
     sendCommand("mission_plan "+plan.toStdString());
 //     std_msgs::String mp;
 //     mp.data = plan.toStdString();
@@ -700,46 +861,35 @@ void ROSLink::sendWaypointIndexUpdate(int waypoint_index)
 
 void ROSLink::updateLocation(const QGeoCoordinate& location)
 {
-    prepareGeometryChange();
     //if(m_have_local_reference)
     {
-        m_location_history.push_back(location);
-        //m_local_location_history.push_back(geoToPixel(location,autonomousVehicleProject())-m_local_reference_position);
-        m_local_location_history.push_back(geoToPixel(location,autonomousVehicleProject()));
-        while (m_local_location_history.size()>500)
-            m_local_location_history.pop_front();
+        m_location_history.append(location,geoToPixel(location,autonomousVehicleProject()));
         m_location = location;
-        update();
+        // a new line started, which the vehicle needs now
+        if(m_adaptive_spacing.updateLocation(location))
+            sendWaypoints(m_adaptive_spacing.waypoints());
+        requestFrame(VehicleLayer);
     }
 }
 
 void ROSLink::updatePosmvLocation(const QGeoCoordinate& location)
 {
-    prepareGeometryChange();
     if(m_have_local_reference)
     {
-        m_posmv_location_history.push_back(location);
-        m_local_posmv_location_history.push_back(geoToPixel(location,autonomousVehicleProject())-m_local_reference_position);
-        while (m_local_posmv_location_history.size()>1500)
-            m_local_posmv_location_history.pop_front();
+        m_posmv_location_history.append(location,geoToPixel(location,autonomousVehicleProject())-m_local_reference_position);
         m_posmv_location = location;
-        update();
+        requestFrame(PosmvLayer);
     }
 }
 
 
 void ROSLink::updateBaseLocation(const QGeoCoordinate& location)
 {
-    prepareGeometryChange();
 //    if(m_have_local_reference)
     {
-        m_base_location_history.push_back(location);
-        //m_local_base_location_history.push_back(geoToPixel(location,autonomousVehicleProject())-m_local_reference_position);
-        m_local_base_location_history.push_back(geoToPixel(location,autonomousVehicleProject()));
-        while (m_local_base_location_history.size()>100)
-            m_local_base_location_history.pop_front();
+        m_base_location_history.append(location,geoToPixel(location,autonomousVehicleProject()));
         m_base_location = location;
-        update();
+        requestFrame(BaseLayer);
     }
 }
 
@@ -759,39 +909,29 @@ void ROSLink::updateOriginLocation(const QGeoCoordinate& location)
 
 void ROSLink::updateHeading(double heading)
 {
-    prepareGeometryChange();
     m_heading = heading;
-    update();
+    requestFrame(VehicleLayer);
 }
 
 void ROSLink::updatePosmvHeading(double heading)
 {
-    prepareGeometryChange();
     m_posmv_heading = heading;
-    update();
+    requestFrame(PosmvLayer);
 }
 
 void ROSLink::updateBaseHeading(double heading)
 {
-    prepareGeometryChange();
     m_base_heading = heading;
-    update();
+    requestFrame(BaseLayer);
 }
 
-void ROSLink::addAISContact(ROSAISContact *c)
+void ROSLink::addAISContact(AISContactReport const &report)
 {
-    //c->setParent(this);
-    prepareGeometryChange();
+    QPointF local;
     if(m_have_local_reference)
-    {
-        c->location_local = geoToPixel(c->location,autonomousVehicleProject())-m_local_reference_position;
-    }
-    m_contacts[c->mmsi].push_back(c);
-    while(!m_contacts[c->mmsi].empty() && (ros::Time::now() - m_contacts[c->mmsi].front()->timestamp) > ros::Duration(600))
-        m_contacts[c->mmsi].pop_front();
-//     while(m_contacts[c->mmsi].size() > 50)
-//         m_contacts[c->mmsi].pop_front();
-    update();
+        local = geoToPixel(QGeoCoordinate(report.latitude,report.longitude),autonomousVehicleProject())-m_local_reference_position;
+    m_contacts.add(report,local);
+    requestFrame(AISLayer);
 }
 
 void ROSLink::updateBackground(BackgroundRaster *bgr)
@@ -802,27 +942,16 @@ void ROSLink::updateBackground(BackgroundRaster *bgr)
 
 void ROSLink::recalculatePositions()
 {
-    prepareGeometryChange();
     //setPos(geoToPixel(m_origin,autonomousVehicleProject()));
     setPos(0,0);
-    m_local_location_history.clear();
-    for(auto l: m_location_history)
-    {
-        m_local_location_history.push_back(geoToPixel(l,autonomousVehicleProject()));            
-    }
+    m_glyphs.clear();
+    auto toPixel = [this](QGeoCoordinate const &l){return geoToPixel(l,autonomousVehicleProject());};
+    m_location_history.reproject(toPixel);
     if(m_have_local_reference)
     {
         m_local_reference_position = geoToPixel(m_origin,autonomousVehicleProject());
-        m_local_posmv_location_history.clear();
-        for(auto l: m_posmv_location_history)
-        {
-            m_local_posmv_location_history.push_back(geoToPixel(l,autonomousVehicleProject())-m_local_reference_position);            
-        }
-        for(auto contactList: m_contacts)
-        {
-            for(auto contact: contactList.second)
-                contact->location_local = geoToPixel(contact->location,autonomousVehicleProject())-m_local_reference_position;
-        }
+        m_posmv_location_history.reproject([this](QGeoCoordinate const &l){return geoToPixel(l,autonomousVehicleProject())-m_local_reference_position;});
+        m_contacts.reproject([this](QGeoCoordinate const &l){return geoToPixel(l,autonomousVehicleProject())-m_local_reference_position;});
         
         updateViewPoint(m_view_point, geoToPixel(m_view_point,autonomousVehicleProject())-m_local_reference_position, m_view_point_active);
         
@@ -839,13 +968,15 @@ void ROSLink::recalculatePositions()
             local_view_seglist.append(geoToPixel(p,autonomousVehicleProject())-m_local_reference_position);
         }
         updateViewSeglist(m_view_seglist,local_view_seglist,m_view_seglist_active);
+
+        for(int r = 0; r < m_coverage.size(); r++)
+            for(int i = 0; i < m_coverage[r].size(); i++)
+                m_local_coverage[r][i] = geoToPixel(m_coverage[r][i],autonomousVehicleProject())-m_local_reference_position;
+        rebuildCoveragePath();
     }
-    m_local_base_location_history.clear();
-    for(auto l: m_base_location_history)
-    {
-        m_local_base_location_history.push_back(geoToPixel(l,autonomousVehicleProject()));            
-    }
-    update();
+    m_base_location_history.reproject(toPixel);
+    m_dirty_layers = AllLayers;
+    renderFrame();
 }
 
 
@@ -893,6 +1024,18 @@ AutonomousVehicleProject * ROSLink::autonomousVehicleProject() const
     return qobject_cast<AutonomousVehicleProject*>(parent());
 }
 
+ros::Time ROSLink::now() const
+{
+    qint64 replay_time = m_replay_time;
+    if(replay_time)
+    {
+        ros::Time ret;
+        ret.fromNSec(replay_time);
+        return ret;
+    }
+    return ros::Time::now();
+}
+
 QMap<QString, QString> ROSLink::parseViewString(const QString& vs) const
 {
     // return key-value pairs.
@@ -965,11 +1108,10 @@ void ROSLink::viewPointCallback(const std_msgs::String::ConstPtr& message)
 
 void ROSLink::updateViewPoint(QGeoCoordinate view_point, QPointF local_view_point, bool view_point_active)
 {
-    prepareGeometryChange();
     m_view_point = view_point;
     m_local_view_point = local_view_point;
     m_view_point_active = true;//view_point_active;
-    update();
+    requestFrame(ViewLayer);
 }
 
 
@@ -1000,11 +1142,10 @@ void ROSLink::viewPolygonCallback(const std_msgs::String::ConstPtr& message)
 
 void ROSLink::updateViewPolygon(QList<QGeoCoordinate> view_polygon, QList<QPointF> local_view_polygon, bool view_polygon_active)
 {
-    prepareGeometryChange();
     m_view_polygon = view_polygon;
     m_local_view_polygon = local_view_polygon;
     m_view_polygon_active = view_polygon_active;
-    update();
+    requestFrame(ViewLayer);
 }
 
 void ROSLink::viewSeglistCallback(const std_msgs::String::ConstPtr& message)
@@ -1033,19 +1174,23 @@ void ROSLink::viewSeglistCallback(const std_msgs::String::ConstPtr& message)
 
 void ROSLink::updateViewSeglist(QList<QGeoCoordinate> view_seglist, QList<QPointF> local_view_seglist, bool view_seglist_active)
 {
-    prepareGeometryChange();
     m_view_seglist = view_seglist;
     m_local_view_seglist = local_view_seglist;
     m_view_seglist_active = view_seglist_active;
-    update();
+    requestFrame(ViewLayer);
 }
 
 void ROSLink::coverageCallback(const geographic_msgs::GeoPath::ConstPtr& message)
 {
-    QList<QList<QGeoCoordinate> > coverage;
-    QList<QPolygonF> local_coverage;
-    coverage.push_back(QList<QGeoCoordinate>());
-    local_coverage.push_back(QPolygonF());
+    // The whole coverage arrives each time, with invalid positions between
+    // rings. Only vertices past those already received are handed on, unless
+    // earlier ones changed or rings went away, which resends everything.
+    QList<QList<QGeoCoordinate> > &received = m_received_coverage;
+    QList<QList<QGeoCoordinate> > added;
+    int first_ring = -1;
+    int ring = 0;
+    int vertex = 0;
+    bool reset = false;
     for(auto gp: message->poses)
     {
         QGeoCoordinate gc;
@@ -1053,16 +1198,72 @@ void ROSLink::coverageCallback(const geographic_msgs::GeoPath::ConstPtr& message
         gc.setLongitude(gp.pose.position.longitude);
         if(gc.isValid())
         {
-            coverage.back().append(gc);
-            local_coverage.back().append(geoToPixel(gc,autonomousVehicleProject())-m_local_reference_position);
+            if(ring < received.size() && vertex < received[ring].size())
+            {
+                if(received[ring][vertex] != gc)
+                {
+                    reset = true;
+                    break;
+                }
+            }
+            else
+            {
+                if(first_ring < 0)
+                    first_ring = qMin(ring,received.size());
+                while(added.size() <= ring-first_ring)
+                    added.append(QList<QGeoCoordinate>());
+                added.back().append(gc);
+            }
+            vertex++;
         }
         else
         {
-            coverage.push_back(QList<QGeoCoordinate>());
-            local_coverage.push_back(QPolygonF());
+            if(ring < received.size() && vertex < received[ring].size())
+            {
+                reset = true;
+                break;
+            }
+            ring++;
+            vertex = 0;
         }
     }
-    QMetaObject::invokeMethod(this,"updateCoverage", Qt::QueuedConnection, Q_ARG(QList<QList<QGeoCoordinate> >, coverage), Q_ARG(QList<QPolygonF>, local_coverage));
+    if(ring+1 < received.size() || (ring < received.size() && vertex < received[ring].size()))
+        reset = true;
+
+    if(reset)
+    {
+        added.clear();
+        added.append(QList<QGeoCoordinate>());
+        for(auto gp: message->poses)
+        {
+            QGeoCoordinate gc;
+            gc.setLatitude(gp.pose.position.latitude);
+            gc.setLongitude(gp.pose.position.longitude);
+            if(gc.isValid())
+                added.back().append(gc);
+            else
+                added.append(QList<QGeoCoordinate>());
+        }
+        received = added;
+        first_ring = 0;
+    }
+    else
+    {
+        // rings without new vertices still count
+        if(first_ring < 0 && ring >= received.size())
+            first_ring = received.size();
+        if(first_ring < 0)
+            return;
+        while(added.size() < ring+1-first_ring)
+            added.append(QList<QGeoCoordinate>());
+        for(int i = 0; i < added.size(); i++)
+        {
+            if(first_ring+i == received.size())
+                received.append(QList<QGeoCoordinate>());
+            received[first_ring+i].append(added[i]);
+        }
+    }
+    QMetaObject::invokeMethod(this,"addCoverage", Qt::QueuedConnection, Q_ARG(bool, reset), Q_ARG(int, first_ring), Q_ARG(QList<QList<QGeoCoordinate> >, added));
 }
 
 void ROSLink::currentPathCallback(const geographic_msgs::GeoPath::ConstPtr& message)
@@ -1082,40 +1283,97 @@ void ROSLink::currentPathCallback(const geographic_msgs::GeoPath::ConstPtr& mess
 
 void ROSLink::updateCurrentPath(QList<QGeoCoordinate> current_path, QList<QPointF> local_current_path)
 {
-    prepareGeometryChange();
     m_current_path = current_path;
     m_local_current_path = local_current_path;
-    update();   
+    requestFrame(CurrentPathLayer);
 }
 
 void ROSLink::pingCallback(const sensor_msgs::PointCloud::ConstPtr& message)
 {
-    QList<QGeoCoordinate> ping;
-    QList<QPointF> local_ping;
-//     for(auto gp: message->poses)
-//     {
-//         QGeoCoordinate gc;
-//         gc.setLatitude(gp.pose.position.latitude);
-//         gc.setLongitude(gp.pose.position.longitude);
-//         ping.append(gc);
-//         local_ping.append(geoToPixel(gc,autonomousVehicleProject())-m_local_reference_position);
-//     }
-//     QMetaObject::invokeMethod(this,"addPing", Qt::QueuedConnection, Q_ARG(QList<QGeoCoordinate>, ping), Q_ARG(QList<QPointF>, local_ping));
+    // points are in the map frame, z up
+    QVector<Sounding> soundings;
+    soundings.reserve(message->points.size());
+    for(auto const &p: message->points)
+    {
+        Sounding s;
+        s.x = p.x;
+        s.y = p.y;
+        s.depth = -p.z;
+        soundings.append(s);
+    }
+    QMetaObject::invokeMethod(m_depth_grid,"addSoundings", Qt::QueuedConnection, Q_ARG(QVector<Sounding>, soundings));
+}
+
+void ROSLink::depthGridUpdated()
+{
+    requestFrame(PingsLayer);
+}
+
+
+void ROSLink::addCoverage(bool reset, int first_ring, QList<QList<QGeoCoordinate> > coverage)
+{
+    if(reset)
+    {
+        m_coverage.clear();
+        m_local_coverage.clear();
+    }
+    // only the last ring can be extended at the end of the cached path
+    bool rebuild = reset || first_ring < m_coverage.size()-1;
+    for(int i = 0; i < coverage.size(); i++)
+    {
+        int r = first_ring+i;
+        if(r == m_coverage.size())
+        {
+            m_coverage.append(QList<QGeoCoordinate>());
+            m_local_coverage.append(QPolygonF());
+        }
+        for(auto gc: coverage[i])
+        {
+            QPointF p = geoToPixel(gc,autonomousVehicleProject())-m_local_reference_position;
+            m_coverage[r].append(gc);
+            m_local_coverage[r].append(p);
+            if(!rebuild)
+            {
+                if(m_local_coverage[r].size() == 1)
+                    m_coverage_path.moveTo(p);
+                else
+                    m_coverage_path.lineTo(p);
+            }
+        }
+    }
+    if(rebuild)
+        rebuildCoveragePath();
+    if(m_adaptive_spacing.updateCoverage(reset,first_ring,coverage))
+        sendWaypoints(m_adaptive_spacing.waypoints());
+    requestFrame(CoverageLayer);
+}
+
+void ROSLink::rebuildCoveragePath()
+{
+    m_coverage_path = QPainterPath();
+    for(auto p: m_local_coverage)
+        m_coverage_path.addPolygon(p);
 }
 
+void ROSLink::startAdaptiveSpacing(const QGeoCoordinate& start, const QGeoCoordinate& end, bool starboard, double overlap)
+{
+    m_adaptive_spacing.setOverlap(overlap);
+    m_adaptive_spacing.setLine(start,end,starboard);
+    if(m_adaptive_spacing.active())
+    {
+        // coverage so far, after which only additions are passed on
+        m_adaptive_spacing.updateCoverage(true,0,m_coverage);
+        sendWaypoints(m_adaptive_spacing.waypoints());
+    }
+}
 
-void ROSLink::updateCoverage(QList<QList<QGeoCoordinate> > coverage, QList<QPolygonF> local_coverage)
+void ROSLink::stopAdaptiveSpacing()
 {
-    prepareGeometryChange();
-    m_coverage = coverage;
-    m_local_coverage = local_coverage;
-    update();
+    m_adaptive_spacing.stop();
 }
 
-void ROSLink::addPing(QList<QGeoCoordinate> ping, QList<QPointF> local_ping)
+bool ROSLink::adaptiveSpacingActive() const
 {
-    prepareGeometryChange();
-    m_pings.append(ping);
-    m_local_pings.append(local_ping);
-    update();
+    return m_adaptive_spacing.active();
 }
+
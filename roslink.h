@@ -2,6 +2,16 @@
 #define ROSLINK_H
 
 #include "geographicsitem.h"
+#include "adaptivelinespacing.h"
+#include "trackhistory.h"
+#include "renderscheduler.h"
+#include "aiscontactstore.h"
+#include "vesselglyphs.h"
+#include "telemetryqueue.h"
+#include "depthgrid.h"
+#include "telemetrylog.h"
+#include "telemetryreplay.h"
+#include "roslinklayer.h"
 
 #include "geographic_msgs/GeoPointStamped.h"
 #include "sensor_msgs/NavSatFix.h"
@@ -18,24 +28,7 @@
 Q_DECLARE_METATYPE(ros::Time);
 
 class ROSDetails;
-
-struct ROSAISContact: public QObject
-{
-    Q_OBJECT
-public:
-    ROSAISContact(QObject *parent = nullptr);
-    ros::Time timestamp;
-    uint32_t mmsi;
-    std::string name;
-    QGeoCoordinate location;
-    QPointF location_local;
-    double heading;
-    float dimension_to_stbd; 
-    float dimension_to_port;
-    float dimension_to_bow;
-    float dimension_to_stern; 
-};
-
+class QThread;
 
 class ROSLink : public QObject, public GeoGraphicsItem
 {
@@ -43,17 +36,17 @@ class ROSLink : public QObject, public GeoGraphicsItem
     Q_INTERFACES(QGraphicsItem)
 public:
     ROSLink(AutonomousVehicleProject* parent);
+    ~ROSLink();
     
     QRectF boundingRect() const;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
-    QPainterPath shape() const override;
+    /// Vessel symbols at the latest fixes.
     QPainterPath vehicleShape() const;
     QPainterPath vehicleShapePosmv() const;
     QPainterPath baseShape() const;
     QPainterPath aisShape() const;
     QPainterPath viewShape() const;
     QPainterPath coverageShape() const;
-    QPainterPath pingsShape() const;
     QPainterPath currentPathShape() const;
 
     void write(QJsonObject &json) const;
@@ -69,12 +62,36 @@ public:
     void sendCommand(const std::string& command);
     
     void setROSDetails(ROSDetails *details);
+    
+    /// Telemetry updates apply their state at once but rebuild and repaint
+    /// the layers they touched at most frameRate times a second.
+    void setRenderFrameRate(double frameRate);
+    RenderScheduler::Stats const &renderStats() const;
+
+    /// Runs start to end and keeps the vehicle's next line placed from the live
+    /// swath edge, with overlap as a fraction of the swath width.
+    void startAdaptiveSpacing(QGeoCoordinate const &start, QGeoCoordinate const &end, bool starboard, double overlap);
+    void stopAdaptiveSpacing();
+    bool adaptiveSpacingActive() const;
+
+    /// Logs every message of the subscribed topics as it is received.
+    bool startRecording(QString const &path);
+    void stopRecording();
+    bool recording() const;
+    /// Feeds a recorded log to the same handlers as ROS. Speed 1 is real
+    /// time, 0 as fast as possible. Refused while connected to ROS, and a
+    /// connection coming up stops the replay.
+    bool startReplay(QString const &path, double speed = 1.0);
+    void stopReplay();
+    bool replaying() const;
 
     
 signals:
 
     void rosConnected(bool connected);
     void originUpdated();
+    /// A replay played to the end or was stopped.
+    void replayFinished();
     
 public slots:
     void updateLocation(QGeoCoordinate const &location);
@@ -88,12 +105,13 @@ public slots:
     void updateViewPoint(QGeoCoordinate view_point, QPointF local_view_point, bool view_point_active);
     void updateViewPolygon(QList<QGeoCoordinate> view_polygon, QList<QPointF> local_view_polygon, bool view_polygon_active);
     void updateViewSeglist(QList<QGeoCoordinate> view_seglist, QList<QPointF> local_view_seglist, bool view_seglist_active);
-    void updateCoverage(QList<QList<QGeoCoordinate> > coverage, QList<QPolygonF> local_coverage);
-    void addPing(QList<QGeoCoordinate> ping, QList<QPointF> local_ping);
+    /// Appends coverage vertices to rings from first_ring on, creating rings
+    /// as needed, after clearing everything if reset is set.
+    void addCoverage(bool reset, int first_ring, QList<QList<QGeoCoordinate> > coverage);
     void updateCurrentPath(QList<QGeoCoordinate> current_path, QList<QPointF> local_current_path);
 
     void recalculatePositions();
-    void addAISContact(ROSAISContact *c);
+    void addAISContact(AISContactReport const &report);
     void sendWaypoints(QList<QGeoCoordinate> const &waypoints);
     void sendMissionPlan(QString const &plan);
     void sendLoiter(QGeoCoordinate const &loiterLocation);
@@ -103,8 +121,43 @@ public slots:
     void updateHeartbeatTimes(ros::Time const &last_heartbeat_timestamp, ros::Time const &last_heartbeat_receive_time);
     void watchdogUpdate();
     void updateSog(qreal sog);
+    void updateMapScale(qreal scale);
     
+private slots:
+    void updateFrame();
+    void renderFrame();
+    void depthGridUpdated();
+
 private:
+    enum Layer
+    {
+        VehicleLayer = 0x01,
+        PosmvLayer = 0x02,
+        BaseLayer = 0x04,
+        AISLayer = 0x08,
+        ViewLayer = 0x10,
+        CurrentPathLayer = 0x20,
+        CoverageLayer = 0x40,
+        PingsLayer = 0x80,
+        AllLayers = 0xff
+    };
+
+    /// Marks layers for rebuilding at the next frame.
+    void requestFrame(int layers);
+
+    /// Registers a subscription handler under its topic name.
+    template<typename M> void addTopic(std::string const &name, void (ROSLink::*callback)(boost::shared_ptr<M const> const &));
+
+    /// Spinner threads hand telemetry over through m_telemetry and wake the
+    /// GUI thread at most once per drain, which happens at the next frame.
+    void pushTelemetry(TelemetryRecord const &record);
+    void wakeTelemetry();
+    void drainTelemetry();
+    void rebuildCoveragePath();
+    /// The multibeam depth grid level that suits the zoom, placed on the map,
+    /// over coarser tiles where its own were evicted.
+    QList<ROSLinkRasterLayer::Tile> depthTiles() const;
+
     void geoPointStampedCallback(const geographic_msgs::GeoPointStamped::ConstPtr& message);
     void baseNavSatFixCallback(const sensor_msgs::NavSatFix::ConstPtr& message);
     void originCallback(const geographic_msgs::GeoPoint::ConstPtr& message);
@@ -132,26 +185,25 @@ private:
     QGeoCoordinate rosMapToGeo(QPointF const &location) const;
     
     AutonomousVehicleProject *autonomousVehicleProject() const;
+    /// The time telemetry ages against: the replayed log's clock after a
+    /// replay, otherwise the wall clock.
+    ros::Time now() const;
     
     ros::NodeHandle *m_node;
-    ros::Subscriber m_geopoint_subscriber;
-    ros::Subscriber m_base_navsatfix_subscriber;
-    ros::Subscriber m_origin_subscriber;
-    ros::Subscriber m_heading_subscriber;
-    ros::Subscriber m_base_heading_subscriber;
-    ros::Subscriber m_ais_subscriber;
-    ros::Subscriber m_heartbeat_subscriber;
-    ros::Subscriber m_view_point_subscriber;
-    ros::Subscriber m_view_polygon_subscriber;
-    ros::Subscriber m_view_seglist_subscriber;
-    ros::Subscriber m_posmv_position;
-    ros::Subscriber m_posmv_orientation;
-    ros::Subscriber m_range_subscriber;
-    ros::Subscriber m_bearing_subscriber;
-    ros::Subscriber m_sog_subscriber;
-    ros::Subscriber m_coverage_subscriber;
-    ros::Subscriber m_ping_subscriber;
-    ros::Subscriber m_current_path_subscriber;
+    /// A subscribed topic, which can also be recorded and replayed.
+    struct Topic
+    {
+        std::string name;
+        std::function<ros::Subscriber(ros::NodeHandle &)> subscribe;
+        std::function<void(char const *, quint32)> replay;
+    };
+
+    std::vector<Topic> m_topics;
+    std::vector<ros::Subscriber> m_subscribers;
+    TelemetryLogWriter m_recorder;
+    TelemetryReplay *m_replay;
+    // nanoseconds since the epoch of the last replayed message, 0 when live
+    std::atomic<qint64> m_replay_time;
     
     //ros::Publisher m_active_publisher;
     //ros::Publisher m_helmMode_publisher;
@@ -165,12 +217,9 @@ private:
     QGeoCoordinate m_posmv_location;
     QGeoCoordinate m_base_location; // location of the base operator station (ship, shore station, etc)
     QGeoCoordinate m_origin;
-    std::vector<QGeoCoordinate> m_location_history;
-    std::list<QPointF> m_local_location_history;
-    std::vector<QGeoCoordinate> m_posmv_location_history;
-    std::list<QPointF> m_local_posmv_location_history;
-    std::vector<QGeoCoordinate> m_base_location_history;
-    std::list<QPointF> m_local_base_location_history;
+    TrackHistory m_location_history;
+    TrackHistory m_posmv_location_history;
+    TrackHistory m_base_location_history;
     QPointF m_local_reference_position;
     bool m_have_local_reference;
     double m_heading;
@@ -179,10 +228,8 @@ private:
     bool m_active;
     std::string m_helmMode;
     
-    typedef std::list<ROSAISContact*> ContactList;
-    typedef std::map<uint32_t,ContactList> ContactMap;
-    
-    ContactMap m_contacts;
+    AISContactStore m_contacts;
+    mutable VesselGlyphs m_glyphs;
     ROSDetails *m_details;
     
     QGeoCoordinate m_view_point;
@@ -199,9 +246,12 @@ private:
 
     QList<QList<QGeoCoordinate> > m_coverage;
     QList<QPolygonF> m_local_coverage;
+    QPainterPath m_coverage_path;
+    QList<QList<QGeoCoordinate> > m_received_coverage; // spinner thread only
+    AdaptiveLineSpacing m_adaptive_spacing;
 
-    QList<QList<QGeoCoordinate> > m_pings;
-    QList<QList<QPointF> > m_local_pings;
+    DepthGrid * m_depth_grid;
+    QThread * m_depth_grid_thread;
 
     QList<QGeoCoordinate> m_current_path;
     QList<QPointF> m_local_current_path;
@@ -210,6 +260,18 @@ private:
     ros::Time m_last_heartbeat_receive_time;
     
     QTimer * m_watchdog_timer;
+    RenderScheduler * m_render_scheduler;
+    int m_dirty_layers;
+    bool m_in_frame;
+    TelemetryQueue m_telemetry;
+    ROSLinkLayer * m_vehicle_layer;
+    ROSLinkLayer * m_posmv_layer;
+    ROSLinkLayer * m_base_layer;
+    ROSLinkLayer * m_ais_layer;
+    ROSLinkLayer * m_view_layer;
+    ROSLinkLayer * m_current_path_layer;
+    ROSLinkLayer * m_coverage_layer;
+    ROSLinkRasterLayer * m_pings_layer;
     
     double m_range;
     ros::Time m_range_timestamp;
@@ -0,0 +1,106 @@
+#include "roslinklayer.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+ROSLinkLayer::ROSLinkLayer(QGraphicsItem* parentItem):QGraphicsItem(parentItem),m_brush(Qt::NoBrush)
+{
+    setAcceptHoverEvents(false);
+    setAcceptedMouseButtons(Qt::NoButton);
+}
+
+QRectF ROSLinkLayer::boundingRect() const
+{
+    return m_bounds;
+}
+
+void ROSLinkLayer::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    painter->save();
+    painter->setBrush(m_brush);
+    for(auto const &pen: m_pens)
+    {
+        painter->setPen(pen);
+        for(auto const &path: m_paths)
+            painter->drawPath(path);
+    }
+    painter->restore();
+}
+
+void ROSLinkLayer::setPens(const QList<QPen>& pens)
+{
+    m_pens = pens;
+    update();
+}
+
+void ROSLinkLayer::setBrush(const QBrush& brush)
+{
+    m_brush = brush;
+    update();
+}
+
+void ROSLinkLayer::setPaths(const QList<QPainterPath>& paths, qreal margin)
+{
+    prepareGeometryChange();
+    m_paths = paths;
+    m_bounds = QRectF();
+    bool first = true;
+    for(auto const &path: m_paths)
+    {
+        if(path.isEmpty())
+            continue;
+        // a lone point has an empty rect, which united() would drop
+        QRectF r = path.controlPointRect();
+        if(first)
+            m_bounds = r;
+        else
+        {
+            m_bounds.setLeft(qMin(m_bounds.left(),r.left()));
+            m_bounds.setTop(qMin(m_bounds.top(),r.top()));
+            m_bounds.setRight(qMax(m_bounds.right(),r.right()));
+            m_bounds.setBottom(qMax(m_bounds.bottom(),r.bottom()));
+        }
+        first = false;
+    }
+    if(!first)
+        m_bounds.adjust(-margin,-margin,margin,margin);
+    update();
+}
+
+ROSLinkRasterLayer::ROSLinkRasterLayer(QGraphicsItem* parentItem):QGraphicsItem(parentItem)
+{
+    setAcceptHoverEvents(false);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+QRectF ROSLinkRasterLayer::boundingRect() const
+{
+    return m_bounds;
+}
+
+void ROSLinkRasterLayer::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    for(int i = 0; i < m_tiles.size(); i++)
+    {
+        if(!m_tileBounds[i].intersects(option->exposedRect))
+            continue;
+        painter->save();
+        painter->setTransform(m_tiles[i].transform,true);
+        painter->drawImage(0,0,m_tiles[i].image);
+        painter->restore();
+    }
+}
+
+void ROSLinkRasterLayer::setTiles(const QList<Tile>& tiles)
+{
+    prepareGeometryChange();
+    m_tiles = tiles;
+    m_tileBounds.clear();
+    m_bounds = QRectF();
+    for(auto const &t: m_tiles)
+    {
+        m_tileBounds.append(t.transform.mapRect(QRectF(t.image.rect())));
+        m_bounds |= m_tileBounds.back();
+    }
+    update();
+}
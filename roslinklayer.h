@@ -0,0 +1,61 @@
+#ifndef ROSLINKLAYER_H
+#define ROSLINKLAYER_H
+
+#include <QGraphicsItem>
+#include <QBrush>
+#include <QImage>
+#include <QList>
+#include <QPainterPath>
+#include <QPen>
+#include <QTransform>
+
+/// One kind of ROSLink overlay (vehicle, AIS, coverage...) as its own child
+/// item. It keeps the paths it was last given along with their bounds, so a
+/// change to one layer neither repaints nor re-measures the others.
+class ROSLinkLayer : public QGraphicsItem
+{
+public:
+    explicit ROSLinkLayer(QGraphicsItem *parentItem);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+    /// Every path is stroked with each pen in turn, so wide pens drawn first
+    /// outline the narrower ones.
+    void setPens(QList<QPen> const &pens);
+    void setBrush(QBrush const &brush);
+    /// Replaces the geometry. margin pads the bounds for the pen widths.
+    void setPaths(QList<QPainterPath> const &paths, qreal margin);
+
+private:
+    QList<QPainterPath> m_paths;
+    QList<QPen> m_pens;
+    QBrush m_brush;
+    QRectF m_bounds;
+};
+
+/// Georeferenced images as a ROSLink child layer, each drawn through its own
+/// transform from image pixels to item coordinates.
+class ROSLinkRasterLayer : public QGraphicsItem
+{
+public:
+    struct Tile
+    {
+        QImage image;
+        QTransform transform;
+    };
+
+    explicit ROSLinkRasterLayer(QGraphicsItem *parentItem);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+    void setTiles(QList<Tile> const &tiles);
+
+private:
+    QList<Tile> m_tiles;
+    QList<QRectF> m_tileBounds;
+    QRectF m_bounds;
+};
+
+#endif // ROSLINKLAYER_H
@@ -0,0 +1,283 @@
+#include "rtree.h"
+#include <QtMath>
+#include <algorithm>
+#include <queue>
+
+namespace
+{
+    typedef RTree::Box Box;
+
+    Box toBox(QRectF const &r)
+    {
+        QRectF n = r.normalized();
+        Box b = {n.left(),n.top(),n.right(),n.bottom()};
+        return b;
+    }
+
+    bool overlaps(Box const &a, Box const &b)
+    {
+        return a.x0 <= b.x1 && b.x0 <= a.x1 && a.y0 <= b.y1 && b.y0 <= a.y1;
+    }
+
+    Box unite(Box const &a, Box const &b)
+    {
+        Box r = {std::min(a.x0,b.x0),std::min(a.y0,b.y0),std::max(a.x1,b.x1),std::max(a.y1,b.y1)};
+        return r;
+    }
+
+    // Liang-Barsky clip of the segment against the box.
+    bool segmentOverlaps(QPointF const &a, QPointF const &b, Box const &box)
+    {
+        double t0 = 0.0, t1 = 1.0;
+        double dx = b.x()-a.x();
+        double dy = b.y()-a.y();
+        double p[4] = {-dx,dx,-dy,dy};
+        double q[4] = {a.x()-box.x0,box.x1-a.x(),a.y()-box.y0,box.y1-a.y()};
+        for(int i = 0; i < 4; i++)
+        {
+            if(p[i] == 0.0)
+            {
+                if(q[i] < 0.0)
+                    return false;
+            }
+            else
+            {
+                double t = q[i]/p[i];
+                if(p[i] < 0.0)
+                    t0 = std::max(t0,t);
+                else
+                    t1 = std::min(t1,t);
+                if(t0 > t1)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool pointInPolygon(double x, double y, QPolygonF const &polygon)
+    {
+        bool inside = false;
+        int n = polygon.size();
+        for(int i = 0, j = n-1; i < n; j = i++)
+            if((polygon[i].y() > y) != (polygon[j].y() > y) &&
+                x < polygon[j].x()+(polygon[i].x()-polygon[j].x())*(y-polygon[j].y())/(polygon[i].y()-polygon[j].y()))
+                inside = !inside;
+        return inside;
+    }
+
+    double boxDistance(QPointF const &p, Box const &b)
+    {
+        double dx = std::max(0.0,std::max(b.x0-p.x(),p.x()-b.x1));
+        double dy = std::max(0.0,std::max(b.y0-p.y(),p.y()-b.y1));
+        return qSqrt(dx*dx+dy*dy);
+    }
+
+    // Sort-Tile-Recursive: sort by x into vertical slices of whole nodes, then
+    // by y within each slice, so consecutive runs of capacity entries are compact.
+    std::vector<int> strOrder(std::vector<Box> const &boxes, int capacity)
+    {
+        int n = boxes.size();
+        std::vector<int> order(n);
+        for(int i = 0; i < n; i++)
+            order[i] = i;
+        int nodeCount = (n+capacity-1)/capacity;
+        int sliceCount = std::max(1,int(qCeil(qSqrt(nodeCount))));
+        int sliceSize = ((nodeCount+sliceCount-1)/sliceCount)*capacity;
+        std::sort(order.begin(),order.end(),[&boxes](int a, int b){return boxes[a].x0+boxes[a].x1 < boxes[b].x0+boxes[b].x1;});
+        for(int s = 0; s < n; s += sliceSize)
+            std::sort(order.begin()+s,order.begin()+std::min(n,s+sliceSize),[&boxes](int a, int b){return boxes[a].y0+boxes[a].y1 < boxes[b].y0+boxes[b].y1;});
+        return order;
+    }
+}
+
+RTree::RTree(int nodeCapacity):m_nodeCapacity(std::max(2,nodeCapacity))
+{
+}
+
+void RTree::clear()
+{
+    m_levels.clear();
+    m_items.clear();
+    m_boxes.clear();
+}
+
+int RTree::size() const
+{
+    return m_items.size();
+}
+
+void RTree::build(std::vector<QRectF> const &boxes)
+{
+    clear();
+    if(boxes.empty())
+        return;
+
+    std::vector<Box> entries;
+    entries.reserve(boxes.size());
+    for(auto const &r: boxes)
+        entries.push_back(toBox(r));
+
+    m_items = strOrder(entries,m_nodeCapacity);
+    m_boxes.reserve(entries.size());
+    for(int i: m_items)
+        m_boxes.push_back(entries[i]);
+
+    std::vector<Box> const *children = &m_boxes;
+    std::vector<Box> levelBoxes;
+    while(true)
+    {
+        int n = children->size();
+        m_levels.push_back(std::vector<Node>());
+        std::vector<Node> &level = m_levels.back();
+        level.reserve((n+m_nodeCapacity-1)/m_nodeCapacity);
+        for(int i = 0; i < n; i += m_nodeCapacity)
+        {
+            Node node;
+            node.first = i;
+            node.count = std::min(m_nodeCapacity,n-i);
+            node.box = (*children)[i];
+            for(int k = i+1; k < i+node.count; k++)
+                node.box = unite(node.box,(*children)[k]);
+            level.push_back(node);
+        }
+        if(level.size() == 1)
+            break;
+
+        // Pack this level's nodes for the next one up. Reordering them leaves
+        // their own child ranges intact.
+        levelBoxes.clear();
+        for(auto const &node: level)
+            levelBoxes.push_back(node.box);
+        std::vector<int> order = strOrder(levelBoxes,m_nodeCapacity);
+        std::vector<Node> reordered;
+        reordered.reserve(level.size());
+        for(int i: order)
+            reordered.push_back(level[i]);
+        level.swap(reordered);
+        levelBoxes.clear();
+        for(auto const &node: level)
+            levelBoxes.push_back(node.box);
+        children = &levelBoxes;
+    }
+}
+
+template<typename NodeTest, typename LeafTest> std::vector<int> RTree::search(NodeTest const &nodeTest, LeafTest const &leafTest) const
+{
+    std::vector<int> ret;
+    if(m_levels.empty())
+        return ret;
+    std::vector<std::pair<int,int> > stack;
+    stack.push_back(std::make_pair(int(m_levels.size())-1,0));
+    while(!stack.empty())
+    {
+        int level = stack.back().first;
+        Node const &node = m_levels[level][stack.back().second];
+        stack.pop_back();
+        if(!nodeTest(node.box))
+            continue;
+        for(int k = node.first; k < node.first+node.count; k++)
+        {
+            if(level == 0)
+            {
+                if(leafTest(m_boxes[k]))
+                    ret.push_back(m_items[k]);
+            }
+            else
+                stack.push_back(std::make_pair(level-1,k));
+        }
+    }
+    return ret;
+}
+
+std::vector<int> RTree::query(QRectF const &rect) const
+{
+    Box r = toBox(rect);
+    auto test = [&r](Box const &b){return overlaps(b,r);};
+    return search(test,test);
+}
+
+std::vector<int> RTree::queryLine(QPolygonF const &polyline) const
+{
+    std::vector<int> ret;
+    for(int i = 0; i+1 < polyline.size(); i++)
+    {
+        QPointF const &a = polyline[i];
+        QPointF const &b = polyline[i+1];
+        auto test = [&a,&b](Box const &box){return segmentOverlaps(a,b,box);};
+        auto hits = search(test,test);
+        ret.insert(ret.end(),hits.begin(),hits.end());
+    }
+    std::sort(ret.begin(),ret.end());
+    ret.erase(std::unique(ret.begin(),ret.end()),ret.end());
+    return ret;
+}
+
+std::vector<int> RTree::queryPolygon(QPolygonF const &polygon) const
+{
+    if(polygon.empty())
+        return std::vector<int>();
+    Box bounds = toBox(polygon.boundingRect());
+    auto nodeTest = [&bounds](Box const &box){return overlaps(box,bounds);};
+    auto leafTest = [&bounds,&polygon](Box const &box)
+    {
+        if(!overlaps(box,bounds))
+            return false;
+        if(pointInPolygon(box.x0,box.y0,polygon))
+            return true;
+        for(int j = 0, n = polygon.size(); j < n; j++)
+            if(segmentOverlaps(polygon[j],polygon[(j+1)%n],box))
+                return true;
+        return false;
+    };
+    return search(nodeTest,leafTest);
+}
+
+std::vector<int> RTree::nearest(QPointF const &point, int k, double maxDistance, std::function<double(int)> const &distance) const
+{
+    std::vector<int> ret;
+    if(m_levels.empty() || k <= 0)
+        return ret;
+
+    // level -1 marks an item slot in m_items, -2 an item with its exact distance
+    struct Entry
+    {
+        double distance;
+        int level;
+        int index;
+        bool operator>(Entry const &other) const {return distance > other.distance;}
+    };
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+    int root = m_levels.size()-1;
+    Entry start = {boxDistance(point,m_levels[root][0].box),root,0};
+    queue.push(start);
+    while(!queue.empty() && int(ret.size()) < k)
+    {
+        Entry e = queue.top();
+        queue.pop();
+        if(e.distance > maxDistance)
+            break;
+        if(e.level == -2 || (e.level == -1 && !distance))
+        {
+            ret.push_back(m_items[e.index]);
+            continue;
+        }
+        if(e.level == -1)
+        {
+            Entry exact = {distance(m_items[e.index]),-2,e.index};
+            if(exact.distance <= maxDistance)
+                queue.push(exact);
+            continue;
+        }
+        Node const &node = m_levels[e.level][e.index];
+        for(int c = node.first; c < node.first+node.count; c++)
+        {
+            Entry child;
+            child.level = e.level-1;
+            child.index = c;
+            child.distance = boxDistance(point,e.level == 0 ? m_boxes[c] : m_levels[e.level-1][c].box);
+            if(child.distance <= maxDistance)
+                queue.push(child);
+        }
+    }
+    return ret;
+}
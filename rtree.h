@@ -0,0 +1,56 @@
+#ifndef RTREE_H
+#define RTREE_H
+
+#include <QPolygonF>
+#include <QRectF>
+#include <functional>
+#include <limits>
+#include <vector>
+
+/// Static R-tree over bounding boxes, bulk loaded with Sort-Tile-Recursive
+/// packing. Queries return the indices of the boxes passed to build(). Boxes
+/// may be empty, as they are for single points.
+class RTree
+{
+public:
+    explicit RTree(int nodeCapacity = 16);
+
+    void build(std::vector<QRectF> const &boxes);
+    void clear();
+    int size() const;
+
+    std::vector<int> query(QRectF const &rect) const;
+    /// Boxes crossed by any segment of the polyline.
+    std::vector<int> queryLine(QPolygonF const &polyline) const;
+    /// Boxes overlapping the polygon's interior or boundary.
+    std::vector<int> queryPolygon(QPolygonF const &polygon) const;
+    /// Up to k items within maxDistance of point, closest first. Boxes are
+    /// visited best first, so only the neighbourhood of point is touched. If
+    /// given, distance refines an item's box distance to its exact distance
+    /// and must never return less than the box distance.
+    std::vector<int> nearest(QPointF const &point, int k, double maxDistance = std::numeric_limits<double>::max(), std::function<double(int)> const &distance = std::function<double(int)>()) const;
+
+    struct Box
+    {
+        double x0, y0, x1, y1;
+    };
+
+private:
+    struct Node
+    {
+        Box box;
+        int first;
+        int count;
+    };
+
+    template<typename NodeTest, typename LeafTest> std::vector<int> search(NodeTest const &nodeTest, LeafTest const &leafTest) const;
+
+    int m_nodeCapacity;
+    // m_levels[0] holds leaves whose children index m_items, each higher level
+    // indexes the one below it and the last level is the root
+    std::vector<std::vector<Node> > m_levels;
+    std::vector<int> m_items;
+    std::vector<Box> m_boxes;
+};
+
+#endif // RTREE_H
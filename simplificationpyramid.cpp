@@ -0,0 +1,148 @@
+#include "simplificationpyramid.h"
+#include <QtMath>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    const int maxLevels = 10;
+
+    double segmentDistance(QPointF const &p, QPointF const &a, QPointF const &b)
+    {
+        QPointF ab = b-a;
+        QPointF ap = p-a;
+        double length2 = ab.x()*ab.x()+ab.y()*ab.y();
+        double t = 0.0;
+        if(length2 > 0.0)
+            t = std::max(0.0,std::min(1.0,(ap.x()*ab.x()+ap.y()*ab.y())/length2));
+        QPointF d = ap-ab*t;
+        return qSqrt(d.x()*d.x()+d.y()*d.y());
+    }
+
+    // Runs Douglas-Peucker once, recording for each point the largest tolerance
+    // at which it is still kept. A point's value is capped by its parent's so
+    // every level keeps a subset of the finer ones.
+    void significance(QPointF const *points, int begin, int end, std::vector<double> &ret)
+    {
+        double const infinity = std::numeric_limits<double>::max();
+        ret[begin] = infinity;
+        ret[end-1] = infinity;
+        struct Span {int first; int last; double cap;};
+        std::vector<Span> stack;
+        Span s = {begin,end-1,infinity};
+        stack.push_back(s);
+        while(!stack.empty())
+        {
+            Span span = stack.back();
+            stack.pop_back();
+            int farthest = -1;
+            double distance = -1.0;
+            for(int i = span.first+1; i < span.last; i++)
+            {
+                double d = segmentDistance(points[i],points[span.first],points[span.last]);
+                if(d > distance)
+                {
+                    distance = d;
+                    farthest = i;
+                }
+            }
+            if(farthest < 0)
+                continue;
+            double value = std::min(distance,span.cap);
+            ret[farthest] = value;
+            Span left = {span.first,farthest,value};
+            Span right = {farthest,span.last,value};
+            stack.push_back(left);
+            stack.push_back(right);
+        }
+    }
+}
+
+void SimplificationPyramid::clear()
+{
+    m_levels.clear();
+}
+
+void SimplificationPyramid::build(QPointF const *points, std::vector<int> const &ringOffsets, double baseTolerance)
+{
+    clear();
+    m_baseTolerance = baseTolerance;
+    if(ringOffsets.size() < 2)
+        return;
+    int ringCount = ringOffsets.size()-1;
+
+    // the end points of every ring survive at all levels
+    int minimum = 0;
+    std::vector<double> values(ringOffsets.back(),0.0);
+    for(int r = 0; r < ringCount; r++)
+    {
+        int size = ringOffsets[r+1]-ringOffsets[r];
+        minimum += std::min(size,2);
+        if(size > 0)
+            significance(points,ringOffsets[r],ringOffsets[r+1],values);
+    }
+
+    double tol = baseTolerance;
+    for(int l = 0; l < maxLevels; l++, tol *= 4.0)
+    {
+        Level level;
+        level.offsets.reserve(ringCount+1);
+        for(int r = 0; r < ringCount; r++)
+        {
+            level.offsets.push_back(level.points.size());
+            for(int i = ringOffsets[r]; i < ringOffsets[r+1]; i++)
+                if(values[i] > tol)
+                    level.points.push_back(points[i]);
+        }
+        level.offsets.push_back(level.points.size());
+        int kept = level.points.size();
+        m_levels.push_back(level);
+        if(kept <= minimum)
+            break;
+    }
+}
+
+int SimplificationPyramid::levelCount() const
+{
+    return m_levels.size();
+}
+
+double SimplificationPyramid::tolerance(int level) const
+{
+    return m_baseTolerance*qPow(4.0,level);
+}
+
+int SimplificationPyramid::ringCount() const
+{
+    if(m_levels.empty())
+        return 0;
+    return m_levels.front().offsets.size()-1;
+}
+
+int SimplificationPyramid::levelFor(QTransform const &transform) const
+{
+    double scale = qSqrt(transform.m11()*transform.m11()+transform.m12()*transform.m12());
+    if(scale <= 0.0)
+        return -1;
+    return levelFor(0.5/scale);
+}
+
+int SimplificationPyramid::levelFor(double maxError) const
+{
+    int ret = -1;
+    for(int l = 0; l < levelCount() && tolerance(l) <= maxError; l++)
+        ret = l;
+    return ret;
+}
+
+QPointF const *SimplificationPyramid::ring(int level, int ring) const
+{
+    Level const &l = m_levels[level];
+    return l.points.data()+l.offsets[ring];
+}
+
+int SimplificationPyramid::ringSize(int level, int ring) const
+{
+    Level const &l = m_levels[level];
+    return l.offsets[ring+1]-l.offsets[ring];
+}
@@ -0,0 +1,42 @@
+#ifndef SIMPLIFICATIONPYRAMID_H
+#define SIMPLIFICATIONPYRAMID_H
+
+#include <QPointF>
+#include <QTransform>
+#include <vector>
+
+/// Douglas-Peucker simplifications of a set of rings at tolerances growing by
+/// a factor of 4 per level, so a zoomed out view can draw a level whose error
+/// stays under a screen pixel. Each level is packed like the input.
+class SimplificationPyramid
+{
+public:
+    /// ringOffsets holds the first point of each ring followed by the total
+    /// point count. Tolerances are in the same units as points.
+    void build(QPointF const *points, std::vector<int> const &ringOffsets, double baseTolerance = 1.0);
+    void clear();
+
+    int levelCount() const;
+    int ringCount() const;
+    double tolerance(int level) const;
+
+    /// Coarsest level whose tolerance is below maxError, or -1 if the full
+    /// resolution points are needed.
+    int levelFor(double maxError) const;
+    /// Level that stays within half a device pixel under transform.
+    int levelFor(QTransform const &transform) const;
+
+    QPointF const *ring(int level, int ring) const;
+    int ringSize(int level, int ring) const;
+
+private:
+    struct Level
+    {
+        std::vector<QPointF> points;
+        std::vector<int> offsets;
+    };
+    std::vector<Level> m_levels;
+    double m_baseTolerance = 1.0;
+};
+
+#endif // SIMPLIFICATIONPYRAMID_H
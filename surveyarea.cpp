@@ -1,10 +1,15 @@
 #include "surveyarea.h"
 #include "waypoint.h"
+#include "platform.h"
+#include "group.h"
+#include "surveylinegenerator.h"
+#include "surveypartitioner.h"
 #include <QPainter>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QtConcurrent>
 
-SurveyArea::SurveyArea(MissionItem *parent) :GeoGraphicsMissionItem(parent)
+SurveyArea::SurveyArea(MissionItem *parent) :GeoGraphicsMissionItem(parent), m_spacing(0.0), m_direction(0.0)
 {
 }
 
@@ -23,6 +28,17 @@ void SurveyArea::paint(QPainter* painter, const QStyleOptionGraphicsItem* option
     p.setWidth(2);
     painter->setPen(p);
     painter->drawPath(shape());   
+
+    if(!m_linePixels.empty())
+    {
+        if(locked())
+            p.setColor(m_lockedColor);
+        else
+            p.setColor(m_unlockedColor);
+        p.setWidth(3);
+        painter->setPen(p);
+        painter->drawLines(m_linePixels.toVector());
+    }
     painter->restore();
 }
 
@@ -57,6 +73,7 @@ Waypoint * SurveyArea::createWaypoint()
     wp->setFlag(QGraphicsItem::ItemIsMovable);
     wp->setFlag(QGraphicsItem::ItemIsSelectable);
     wp->setFlag(QGraphicsItem::ItemSendsGeometryChanges);
+    connect(wp, &Waypoint::waypointMoved, this, &SurveyArea::waypointHasChanged);
     return wp;
 }
 
@@ -64,7 +81,7 @@ Waypoint * SurveyArea::addWaypoint(const QGeoCoordinate& location)
 {
     Waypoint *wp = createWaypoint();
     wp->setLocation(location);
-    update();
+    updateLines();
     return wp;
 }
 
@@ -86,18 +103,183 @@ QList<Waypoint *> SurveyArea::waypoints() const
     return ret;
 }
 
+double SurveyArea::spacing() const
+{
+    return m_spacing;
+}
+
+double SurveyArea::direction() const
+{
+    return m_direction;
+}
+
+void SurveyArea::setDirectionAndSpacing(double direction, double spacing)
+{
+    m_direction = direction;
+    m_spacing = spacing;
+    updateLines();
+}
+
 QList<QList<QGeoCoordinate> > SurveyArea::getLines() const
+{
+    return m_lines;
+}
+
+QList<QList<QGeoCoordinate> > SurveyArea::rings() const
 {
     QList<QList<QGeoCoordinate> > ret;
+    ret.append(QList<QGeoCoordinate>());
+    for(auto wp: waypoints())
+        ret.back().append(wp->location());
     return ret;
 }
 
+void SurveyArea::updateLines()
+{
+    prepareGeometryChange();
+    m_lines.clear();
+    if(m_spacing > 0.0)
+    {
+        SurveyLineGenerator generator(rings());
+        m_lines = generator.generate(m_direction,m_spacing);
+    }
+    updateLinePixels();
+    emit surveyAreaUpdated();
+}
+
+QFuture<QList<SurveyHeadingSearch::Candidate> > SurveyArea::findBestDirections(int count, int timeBudget) const
+{
+    double speed = 0.0;
+    AutonomousVehicleProject* avp = autonomousVehicleProject();
+    if(m_platform)
+        speed = m_platform->speed()*0.514444; // knots to m/s
+    else if(avp && avp->currentPlatform())
+        speed = avp->currentPlatform()->speed()*0.514444;
+    QList<QList<QGeoCoordinate> > areaRings = rings();
+    double spacing = m_spacing;
+    return QtConcurrent::run([areaRings,spacing,speed,count,timeBudget]()
+    {
+        SurveyLineGenerator generator(areaRings);
+        SurveyHeadingSearch search(generator,spacing,speed);
+        return search.search(count,timeBudget);
+    });
+}
+
+Platform * SurveyArea::platform() const
+{
+    return m_platform;
+}
+
+void SurveyArea::setPlatform(Platform* platform)
+{
+    m_platform = platform;
+}
+
+Group * SurveyArea::partition(QList<Platform *> const &platforms)
+{
+    AutonomousVehicleProject* avp = autonomousVehicleProject();
+    MissionItem *parentItem = qobject_cast<MissionItem*>(parent());
+    if(!avp || !parentItem || platforms.empty() || m_spacing <= 0.0)
+        return nullptr;
+
+    QList<double> speeds;
+    for(auto p: platforms)
+        speeds.append(p->speed());
+
+    SurveyLineGenerator generator(rings());
+    auto parts = SurveyPartitioner::partition(generator,m_direction,m_spacing,speeds);
+    // the area stays whole if it could not be clipped
+    if(parts.empty())
+        return nullptr;
+
+    if(m_partitionGroup)
+        avp->deleteItem(m_partitionGroup.data());
+
+    m_partitionGroup = parentItem->createMissionItem<Group>(objectName()+" partitions");
+    for(int i = 0; i < parts.size(); i++)
+        for(int j = 0; j < parts[i].size(); j++)
+        {
+            // Survey areas have no holes and clipping one can't make any, so
+            // each piece is its exterior ring.
+            QString name = platforms[i]->objectName();
+            if(parts[i].size() > 1)
+                name += " "+QString::number(j+1);
+            SurveyArea *sa = m_partitionGroup->createMissionItem<SurveyArea>(name);
+            QPolygonF const &exterior = parts[i][j].front();
+            sa->setPos(sa->geoToPixel(generator.toGeo(exterior.front()),avp));
+            for(auto const &p: exterior)
+                sa->addWaypoint(generator.toGeo(p));
+            sa->setPlatform(platforms[i]);
+            sa->setDirectionAndSpacing(m_direction,m_spacing);
+            connect(avp,&AutonomousVehicleProject::backgroundUpdated,sa,&SurveyArea::updateBackground);
+        }
+    return m_partitionGroup;
+}
+
+void SurveyArea::updateLinePixels()
+{
+    m_linePixels.clear();
+    auto wps = waypoints();
+    if(!wps.empty())
+        for(auto l: m_lines)
+            m_linePixels.append(QLineF(wps.front()->geoToPixel(l.front(),autonomousVehicleProject()),wps.front()->geoToPixel(l.back(),autonomousVehicleProject())));
+    update();
+}
+
+void SurveyArea::waypointHasChanged(Waypoint* wp)
+{
+    updateLines();
+}
+
 void SurveyArea::write(QJsonObject& json) const
 {
+    MissionItem::write(json);
+    json["type"] = "SurveyArea";
+    QJsonArray wpArray;
+    for(auto wp: waypoints())
+    {
+        QJsonObject wpObject;
+        wp->write(wpObject);
+        wpArray.append(wpObject);
+    }
+    json["waypoints"] = wpArray;
+    json["spacing"] = m_spacing;
+    json["direction"] = m_direction;
 }
 
 void SurveyArea::writeToMissionPlan(QJsonArray& navArray) const
 {
+    if(!m_lines.empty())
+    {
+        QJsonObject params;
+        Platform *platform = m_platform;
+        AutonomousVehicleProject* avp = autonomousVehicleProject();
+        if(!platform && avp)
+            platform = avp->currentPlatform();
+        if(platform)
+            params["speed_ms"] = platform->speed()*0.514444; // knots to m/s
+        for(auto l: m_lines)
+        {
+            QJsonObject navItem;
+            navItem["pathtype"] = "trackline";
+            navItem["type"] = "survey_line";
+            if(!params.empty())
+                navItem["parameters"] = params;
+            writeBehaviorsToMissionPlanObject(navItem);
+            QJsonArray pathNavArray;
+            for(auto p: l)
+            {
+                Waypoint * temp_wp = new Waypoint();
+                temp_wp->setLocation(p);
+                temp_wp->writeNavToMissionPlan(pathNavArray);
+                delete temp_wp;
+            }
+            navItem["nav"] = pathNavArray;
+            navArray.append(navItem);
+        }
+        return;
+    }
+
     QJsonObject navItem;
     navItem["pathtype"] = "area";
     writeBehaviorsToMissionPlanObject(navItem);
@@ -117,12 +299,27 @@ void SurveyArea::writeToMissionPlan(QJsonArray& navArray) const
 
 void SurveyArea::read(const QJsonObject& json)
 {
+    MissionItem::read(json);
+    QJsonArray waypointsArray = json["waypoints"].toArray();
+    for(int wpIndex = 0; wpIndex < waypointsArray.size(); wpIndex++)
+    {
+        QJsonObject wpObject = waypointsArray[wpIndex].toObject();
+        if(wpIndex == 0)
+        {
+            QGeoCoordinate position(wpObject["latitude"].toDouble(),wpObject["longitude"].toDouble());
+            setPos(geoToPixel(position,autonomousVehicleProject()));
+        }
+        Waypoint *wp = createWaypoint();
+        wp->read(wpObject);
+    }
+    setDirectionAndSpacing(json["direction"].toDouble(),json["spacing"].toDouble());
 }
 
 void SurveyArea::updateProjectedPoints()
 {
     for(auto wp: waypoints())
         wp->updateProjectedPoints();
+    updateLinePixels();
 }
 
 bool SurveyArea::canAcceptChildType(const std::string& childType) const
@@ -2,6 +2,13 @@
 #define SURVEYAREA_H
 
 #include "geographicsmissionitem.h"
+#include <QLineF>
+#include "surveyheadingsearch.h"
+#include <QPointer>
+#include <QFuture>
+
+class Platform;
+class Group;
 
 class SurveyArea : public GeoGraphicsMissionItem
 {
@@ -21,6 +28,23 @@ public:
     
     QList<Waypoint *> waypoints() const;
 
+    double spacing() const;
+    double direction() const;
+    void setDirectionAndSpacing(double direction, double spacing);
+
+    /// Searches headings on a worker thread. The area's rings, spacing and
+    /// platform speed are taken when called, so later edits don't affect it.
+    QFuture<QList<SurveyHeadingSearch::Candidate> > findBestDirections(int count = 3, int timeBudget = 1000) const;
+
+    Platform * platform() const;
+    void setPlatform(Platform *platform);
+
+    /// Splits the area into strips, one per platform, with balanced survey time
+    /// and generates their lines. A strip across a concave area becomes one
+    /// sub-area per piece. Sub-areas are placed in a group next to this area,
+    /// replacing those from any previous partitioning.
+    Group * partition(QList<Platform *> const &platforms);
+
     void write(QJsonObject &json) const override;
     void writeToMissionPlan(QJsonArray & navArray) const override;
     void read(const QJsonObject &json) override;
@@ -32,11 +56,23 @@ public:
     QList<QList<QGeoCoordinate> > getLines() const override;
     
 signals:
+    void surveyAreaUpdated();
     
 public slots:
     void updateProjectedPoints();
+    void waypointHasChanged(Waypoint *wp);
     
 private:
+    double m_spacing;
+    double m_direction;
+    QList<QList<QGeoCoordinate> > m_lines;
+    QList<QLineF> m_linePixels;
+    QPointer<Platform> m_platform;
+    QPointer<Group> m_partitionGroup;
+
+    QList<QList<QGeoCoordinate> > rings() const;
+    void updateLines();
+    void updateLinePixels();
 };
 
 #endif
@@ -0,0 +1,83 @@
+#include "surveyareadetails.h"
+#include "ui_surveyareadetails.h"
+#include "surveyarea.h"
+
+SurveyAreaDetails::SurveyAreaDetails(QWidget *parent) :
+    QWidget(parent),
+    ui(new Ui::SurveyAreaDetails),
+    m_surveyArea(nullptr),
+    updating(false)
+{
+    ui->setupUi(this);
+    connect(&m_headingSearch,&QFutureWatcher<QList<SurveyHeadingSearch::Candidate> >::finished,this,&SurveyAreaDetails::headingSearchFinished);
+}
+
+SurveyAreaDetails::~SurveyAreaDetails()
+{
+    delete ui;
+}
+
+void SurveyAreaDetails::setSurveyArea(SurveyArea *surveyArea)
+{
+    if(m_surveyArea)
+        disconnect(m_surveyArea,&SurveyArea::surveyAreaUpdated,this,&SurveyAreaDetails::onSurveyAreaUpdated);
+    m_surveyArea = surveyArea;
+    connect(surveyArea,&SurveyArea::surveyAreaUpdated,this,&SurveyAreaDetails::onSurveyAreaUpdated);
+    onSurveyAreaUpdated();
+}
+
+void SurveyAreaDetails::onSurveyAreaUpdated()
+{
+    if(!updating)
+    {
+        ui->lineSpacingLineEdit->setText(QString::number(m_surveyArea->spacing()));
+        ui->directionLineEdit->setText(QString::number(m_surveyArea->direction()));
+    }
+    ui->lineCountLabel->setText(QString::number(m_surveyArea->getLines().size()));
+}
+
+void SurveyAreaDetails::updateSurveyArea()
+{
+    updating = true;
+    m_surveyArea->setDirectionAndSpacing(ui->directionLineEdit->text().toDouble(),ui->lineSpacingLineEdit->text().toDouble());
+    updating = false;
+}
+
+void SurveyAreaDetails::on_lineSpacingLineEdit_editingFinished()
+{
+    updateSurveyArea();
+}
+
+void SurveyAreaDetails::on_directionLineEdit_editingFinished()
+{
+    updateSurveyArea();
+}
+
+void SurveyAreaDetails::on_findHeadingPushButton_clicked(bool checked)
+{
+    ui->findHeadingPushButton->setEnabled(false);
+    m_headingSearchArea = m_surveyArea;
+    m_headingSearch.setFuture(m_surveyArea->findBestDirections());
+}
+
+void SurveyAreaDetails::headingSearchFinished()
+{
+    ui->findHeadingPushButton->setEnabled(true);
+    if(m_headingSearchArea != m_surveyArea)
+        return;
+    auto candidates = m_headingSearch.result();
+    ui->headingCandidatesComboBox->clear();
+    for(auto c: candidates)
+    {
+        QString label = QString::number(c.direction,'f',1)+" degs, "+QString::number(c.lineCount)+" lines, ETE: "+QString::number(int(c.time/60.0))+" (min)";
+        ui->headingCandidatesComboBox->addItem(label,c.direction);
+    }
+    if(!candidates.empty())
+        on_headingCandidatesComboBox_activated(0);
+}
+
+void SurveyAreaDetails::on_headingCandidatesComboBox_activated(int index)
+{
+    double direction = ui->headingCandidatesComboBox->itemData(index).toDouble();
+    m_surveyArea->setDirectionAndSpacing(direction,m_surveyArea->spacing());
+}
@@ -0,0 +1,47 @@
+#ifndef SURVEYAREADETAILS_H
+#define SURVEYAREADETAILS_H
+
+#include <QWidget>
+#include <QFutureWatcher>
+#include <QPointer>
+#include "surveyheadingsearch.h"
+
+namespace Ui {
+class SurveyAreaDetails;
+}
+
+class SurveyArea;
+
+class SurveyAreaDetails : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SurveyAreaDetails(QWidget *parent = 0);
+    ~SurveyAreaDetails();
+
+    void setSurveyArea(SurveyArea *surveyArea);
+
+public slots:
+    void onSurveyAreaUpdated();
+
+private slots:
+    void on_lineSpacingLineEdit_editingFinished();
+    void on_directionLineEdit_editingFinished();
+    void on_findHeadingPushButton_clicked(bool checked);
+    void on_headingCandidatesComboBox_activated(int index);
+    void headingSearchFinished();
+
+private:
+    Ui::SurveyAreaDetails *ui;
+
+    SurveyArea * m_surveyArea;
+    bool updating;
+    QFutureWatcher<QList<SurveyHeadingSearch::Candidate> > m_headingSearch;
+    // the area being searched, whose candidates are dropped if it is no longer shown
+    QPointer<SurveyArea> m_headingSearchArea;
+
+    void updateSurveyArea();
+};
+
+#endif // SURVEYAREADETAILS_H
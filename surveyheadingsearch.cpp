@@ -0,0 +1,108 @@
+#include "surveyheadingsearch.h"
+#include "surveylinegenerator.h"
+#include <QtMath>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+SurveyHeadingSearch::SurveyHeadingSearch(SurveyLineGenerator const &generator, double spacing, double speed):m_generator(generator),m_spacing(spacing),m_speed(speed)
+{
+}
+
+double SurveyHeadingSearch::surveyTime(QList<QLineF> const &lines, double spacing, double speed)
+{
+    double minimumTurn = M_PI*spacing/2.0;
+    double distance = 0.0;
+    for(int i = 0; i < lines.size(); i++)
+    {
+        distance += lines[i].length();
+        if(i > 0)
+            distance += std::max(minimumTurn,QLineF(lines[i-1].p2(),lines[i].p1()).length());
+    }
+    if(speed > 0.0)
+        return distance/speed;
+    return distance;
+}
+
+SurveyHeadingSearch::Candidate SurveyHeadingSearch::evaluate(double direction) const
+{
+    Candidate ret;
+    ret.direction = std::fmod(std::fmod(direction,180.0)+180.0,180.0);
+    QList<QLineF> lines = m_generator.generateLocal(ret.direction,m_spacing);
+    ret.time = surveyTime(lines,m_spacing,m_speed);
+    ret.lineCount = lines.size();
+    return ret;
+}
+
+QList<SurveyHeadingSearch::Candidate> SurveyHeadingSearch::search(int count, int timeBudget) const
+{
+    QList<Candidate> ret;
+    if(m_spacing <= 0.0 || m_generator.localRings().empty())
+        return ret;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::vector<Candidate> results;
+    std::mutex resultsMutex;
+    unsigned int threadCount = std::max(1u,std::thread::hardware_concurrency());
+
+    auto byTime = [](Candidate const &a, Candidate const &b){return a.time < b.time;};
+
+    // Lines are run in both directions so only half the compass needs searching.
+    // Each pass halves the step around the best headings found so far.
+    double step = 5.0;
+    std::vector<double> headings;
+    for(double h = 0.0; h < 180.0; h += step)
+        headings.push_back(h);
+
+    while(!headings.empty() && timer.elapsed() < timeBudget)
+    {
+        std::atomic<std::size_t> next(0);
+        std::vector<std::thread> workers;
+        for(unsigned int t = 0; t < threadCount; t++)
+            workers.push_back(std::thread([&]()
+            {
+                std::size_t i;
+                while((i = next++) < headings.size() && timer.elapsed() < timeBudget)
+                {
+                    Candidate c = evaluate(headings[i]);
+                    std::lock_guard<std::mutex> lock(resultsMutex);
+                    results.push_back(c);
+                }
+            }));
+        for(auto &w: workers)
+            w.join();
+
+        step /= 2.0;
+        if(step < 0.1)
+            break;
+        std::sort(results.begin(),results.end(),byTime);
+        headings.clear();
+        for(std::size_t i = 0; i < results.size() && i < std::size_t(std::max(count,1)); i++)
+        {
+            headings.push_back(results[i].direction-step);
+            headings.push_back(results[i].direction+step);
+        }
+    }
+
+    std::sort(results.begin(),results.end(),byTime);
+    for(auto const &c: results)
+    {
+        if(ret.size() >= count)
+            break;
+        bool distinct = true;
+        for(auto const &r: ret)
+        {
+            double diff = std::fabs(r.direction-c.direction);
+            if(std::min(diff,180.0-diff) < 2.0)
+                distinct = false;
+        }
+        if(distinct)
+            ret.append(c);
+    }
+    return ret;
+}
@@ -0,0 +1,41 @@
+#ifndef SURVEYHEADINGSEARCH_H
+#define SURVEYHEADINGSEARCH_H
+
+#include <QList>
+#include <QLineF>
+
+class SurveyLineGenerator;
+
+/// Searches line headings for an area, scoring each by the time needed to run
+/// the clipped lines plus the turns and transits between them.
+class SurveyHeadingSearch
+{
+public:
+    struct Candidate
+    {
+        double direction; // degrees, in [0,180)
+        double time; // seconds, or meters if no speed was given
+        int lineCount;
+    };
+
+    SurveyHeadingSearch(SurveyLineGenerator const &generator, double spacing, double speed);
+
+    /// Evaluates headings in parallel, first on a coarse grid then refining around
+    /// the best ones, until the search converges or timeBudget (ms) runs out.
+    /// Returns up to count candidates, best first, at least a few degrees apart.
+    QList<Candidate> search(int count = 3, int timeBudget = 500) const;
+
+    Candidate evaluate(double direction) const;
+
+    /// Time to run lines in order at speed (m/s), including the transit from
+    /// each line to the next. Turns onto an adjacent line cost at least a half
+    /// circle of spacing diameter.
+    static double surveyTime(QList<QLineF> const &lines, double spacing, double speed);
+
+private:
+    SurveyLineGenerator const &m_generator;
+    double m_spacing;
+    double m_speed;
+};
+
+#endif // SURVEYHEADINGSEARCH_H
@@ -0,0 +1,545 @@
+#include "surveylinegenerator.h"
+#include <QtMath>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    // Polygon edge in the rotated frame where lines run along u and are stacked along v.
+    struct Edge
+    {
+        double vlo;
+        double vhi;
+        double u;
+        double dudv;
+    };
+
+    struct CellLine
+    {
+        double v;
+        SurveyLineGenerator::Interval interval;
+    };
+
+    // A run of scanline intervals with one-to-one overlap between neighbouring lines.
+    typedef std::vector<CellLine> Cell;
+
+    double dot(QPointF const &a, QPointF const &b)
+    {
+        return a.x()*b.x()+a.y()*b.y();
+    }
+
+    // Part of a ring inside a strip, entering across one side and leaving
+    // across one; sides are 0 for vmin and 1 for vmax.
+    struct StripChain
+    {
+        QPolygonF points;
+        int sides[2];
+    };
+
+    double ringArea(QPolygonF const &ring)
+    {
+        double twice = 0.0;
+        for(int i = 0, n = ring.size(); i < n; i++)
+        {
+            QPointF const &a = ring[i];
+            QPointF const &b = ring[(i+1)%n];
+            twice += a.x()*b.y()-b.x()*a.y();
+        }
+        return std::abs(twice)/2.0;
+    }
+
+    // Drops repeated vertices and the zero width spikes they leave behind,
+    // such as crossings landing on a vertex that lies on a side.
+    QPolygonF withoutDegenerateVertices(QPolygonF const &ring)
+    {
+        const double tolerance = 1e-6;
+        auto same = [tolerance](QPointF const &a, QPointF const &b)
+        {
+            return std::abs(a.x()-b.x()) < tolerance && std::abs(a.y()-b.y()) < tolerance;
+        };
+        QPolygonF ret;
+        for(auto const &p: ring)
+        {
+            if(!ret.empty() && same(ret.back(),p))
+                continue;
+            // a spike folds back on the vertex before its tip
+            if(ret.size() > 1 && same(ret[ret.size()-2],p))
+            {
+                ret.removeLast();
+                continue;
+            }
+            ret << p;
+        }
+        // the same, across the start of the ring
+        bool changed = true;
+        while(changed && ret.size() > 2)
+        {
+            changed = false;
+            if(same(ret.front(),ret.back()))
+            {
+                ret.removeLast();
+                changed = true;
+            }
+            else if(same(ret[ret.size()-2],ret.front()))
+            {
+                ret.removeLast();
+                changed = true;
+            }
+            else if(same(ret.back(),ret[1]))
+            {
+                ret.removeFirst();
+                changed = true;
+            }
+        }
+        return ret;
+    }
+}
+
+SurveyLineGenerator::SurveyLineGenerator(QList<QList<QGeoCoordinate> > const &rings)
+{
+    if(!rings.empty() && !rings.front().empty())
+        m_reference = rings.front().front();
+    for(auto const &ring: rings)
+    {
+        QPolygonF localRing;
+        for(auto const &location: ring)
+            localRing << toLocal(location);
+        if(localRing.size() > 2)
+            m_rings.append(localRing);
+    }
+}
+
+QPointF SurveyLineGenerator::toLocal(QGeoCoordinate const &location) const
+{
+    qreal distance = m_reference.distanceTo(location);
+    if(distance == 0.0)
+        return QPointF();
+    qreal azimuth = qDegreesToRadians(m_reference.azimuthTo(location));
+    return QPointF(distance*qSin(azimuth),distance*qCos(azimuth));
+}
+
+QGeoCoordinate SurveyLineGenerator::toGeo(QPointF const &point) const
+{
+    qreal distance = qSqrt(point.x()*point.x()+point.y()*point.y());
+    if(distance == 0.0)
+        return m_reference;
+    return m_reference.atDistanceAndAzimuth(distance,qRadiansToDegrees(qAtan2(point.x(),point.y())));
+}
+
+QList<QPolygonF> const &SurveyLineGenerator::localRings() const
+{
+    return m_rings;
+}
+
+QPointF SurveyLineGenerator::alongAxis(double direction)
+{
+    double radians = qDegreesToRadians(direction);
+    return QPointF(qSin(radians),qCos(radians));
+}
+
+QPointF SurveyLineGenerator::acrossAxis(double direction)
+{
+    double radians = qDegreesToRadians(direction);
+    return QPointF(qCos(radians),-qSin(radians));
+}
+
+std::vector<SurveyLineGenerator::Scanline> SurveyLineGenerator::scanlines(double direction, double spacing) const
+{
+    std::vector<Scanline> ret;
+    if(spacing <= 0.0 || m_rings.empty())
+        return ret;
+
+    // unit vector along the lines and its starboard normal, in east/north coordinates
+    QPointF along = alongAxis(direction);
+    QPointF across = acrossAxis(direction);
+
+    std::vector<Edge> edges;
+    double vmin = std::numeric_limits<double>::max();
+    double vmax = std::numeric_limits<double>::lowest();
+    for(auto const &ring: m_rings)
+    {
+        int n = ring.size();
+        for(int i = 0; i < n; i++)
+        {
+            QPointF const &a = ring[i];
+            QPointF const &b = ring[(i+1)%n];
+            double ua = dot(a,along);
+            double va = dot(a,across);
+            double ub = dot(b,along);
+            double vb = dot(b,across);
+            vmin = std::min(vmin,va);
+            vmax = std::max(vmax,va);
+            if(va == vb)
+                continue;
+            Edge e;
+            if(va < vb)
+            {
+                e.vlo = va;
+                e.vhi = vb;
+                e.u = ua;
+            }
+            else
+            {
+                e.vlo = vb;
+                e.vhi = va;
+                e.u = ub;
+            }
+            e.dudv = (ua-ub)/(va-vb);
+            edges.push_back(e);
+        }
+    }
+    std::sort(edges.begin(),edges.end(),[](Edge const &a, Edge const &b){return a.vlo < b.vlo;});
+
+    // Sweep scanlines across the polygon keeping only the edges that straddle the
+    // current line active. Crossings are paired with the even-odd rule which takes
+    // care of concave outlines and holes.
+    std::vector<Edge const *> active;
+    std::vector<double> crossings;
+    std::size_t nextEdge = 0;
+    for(int lineNumber = 0; vmin+spacing*(lineNumber+0.5) < vmax; lineNumber++)
+    {
+        double v = vmin+spacing*(lineNumber+0.5);
+        while(nextEdge < edges.size() && edges[nextEdge].vlo <= v)
+            active.push_back(&edges[nextEdge++]);
+        active.erase(std::remove_if(active.begin(),active.end(),[v](Edge const *e){return e->vhi <= v;}),active.end());
+
+        crossings.clear();
+        for(auto e: active)
+            crossings.push_back(e->u+(v-e->vlo)*e->dudv);
+        std::sort(crossings.begin(),crossings.end());
+
+        ret.push_back(Scanline());
+        ret.back().v = v;
+        for(std::size_t i = 0; i+1 < crossings.size(); i += 2)
+            if(crossings[i+1] > crossings[i])
+            {
+                Interval interval;
+                interval.u0 = crossings[i];
+                interval.u1 = crossings[i+1];
+                ret.back().intervals.push_back(interval);
+            }
+    }
+    return ret;
+}
+
+QList<QLineF> SurveyLineGenerator::generateLocal(double direction, double spacing) const
+{
+    QList<QLineF> ret;
+    QPointF along = alongAxis(direction);
+    QPointF across = acrossAxis(direction);
+
+    std::vector<Cell> cells;
+    std::vector<std::vector<int> > adjacency;
+    std::vector<Interval> previous;
+    std::vector<int> previousCells, currentCells;
+    std::vector<int> previousCount, currentCount, previousPartner, currentPartner;
+    for(auto const &scanline: scanlines(direction,spacing))
+    {
+        double v = scanline.v;
+        std::vector<Interval> const &current = scanline.intervals;
+
+        // An interval continues a cell only if it overlaps exactly one interval of
+        // the previous line which in turn overlaps nothing else. Splits and merges
+        // around islands or inlets start new cells.
+        previousCount.assign(previous.size(),0);
+        previousPartner.assign(previous.size(),-1);
+        currentCount.assign(current.size(),0);
+        currentPartner.assign(current.size(),-1);
+        std::size_t i = 0, j = 0;
+        while(i < previous.size() && j < current.size())
+        {
+            if(previous[i].u0 < current[j].u1 && current[j].u0 < previous[i].u1)
+            {
+                previousCount[i]++;
+                previousPartner[i] = j;
+                currentCount[j]++;
+                currentPartner[j] = i;
+            }
+            if(previous[i].u1 < current[j].u1)
+                i++;
+            else
+                j++;
+        }
+
+        currentCells.assign(current.size(),-1);
+        for(j = 0; j < current.size(); j++)
+        {
+            int partner = currentPartner[j];
+            if(currentCount[j] == 1 && previousCount[partner] == 1)
+                currentCells[j] = previousCells[partner];
+            else
+            {
+                cells.push_back(Cell());
+                adjacency.push_back(std::vector<int>());
+                currentCells[j] = cells.size()-1;
+            }
+            CellLine cl;
+            cl.v = v;
+            cl.interval = current[j];
+            cells[currentCells[j]].push_back(cl);
+        }
+
+        // Cells touching across a split or merge are neighbours.
+        i = j = 0;
+        while(i < previous.size() && j < current.size())
+        {
+            if(previous[i].u0 < current[j].u1 && current[j].u0 < previous[i].u1 && previousCells[i] != currentCells[j])
+            {
+                adjacency[previousCells[i]].push_back(currentCells[j]);
+                adjacency[currentCells[j]].push_back(previousCells[i]);
+            }
+            if(previous[i].u1 < current[j].u1)
+                i++;
+            else
+                j++;
+        }
+        previous = current;
+        std::swap(previousCells,currentCells);
+    }
+
+    if(cells.empty())
+        return ret;
+
+    // Walk the cell adjacency graph depth first, entering each cell from whichever
+    // corner is closest to where the previous one ended. Cells not reachable from
+    // the first one (slivers missed by the line spacing) are picked up afterwards.
+    std::vector<bool> visited(cells.size(),false);
+    std::vector<int> stack;
+    QPointF position(cells.front().front().interval.u0,cells.front().front().v);
+    std::size_t nextUnvisited = 0;
+    while(true)
+    {
+        int bestCell = -1;
+        bool bestFromLast = false;
+        bool bestFromU1 = false;
+        double bestDistance = std::numeric_limits<double>::max();
+        while(bestCell < 0 && !stack.empty())
+        {
+            for(int c: adjacency[stack.back()])
+            {
+                if(visited[c])
+                    continue;
+                for(int fromLast = 0; fromLast < 2; fromLast++)
+                {
+                    CellLine const &cl = fromLast ? cells[c].back() : cells[c].front();
+                    for(int fromU1 = 0; fromU1 < 2; fromU1++)
+                    {
+                        double du = (fromU1 ? cl.interval.u1 : cl.interval.u0)-position.x();
+                        double dv = cl.v-position.y();
+                        double distance = du*du+dv*dv;
+                        if(distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            bestCell = c;
+                            bestFromLast = fromLast;
+                            bestFromU1 = fromU1;
+                        }
+                    }
+                }
+            }
+            if(bestCell < 0)
+                stack.pop_back();
+        }
+        if(bestCell < 0)
+        {
+            while(nextUnvisited < cells.size() && visited[nextUnvisited])
+                nextUnvisited++;
+            if(nextUnvisited == cells.size())
+                break;
+            bestCell = nextUnvisited;
+        }
+        visited[bestCell] = true;
+        stack.push_back(bestCell);
+        Cell const &cell = cells[bestCell];
+        bool fromU1 = bestFromU1;
+        for(std::size_t k = 0; k < cell.size(); k++)
+        {
+            CellLine const &cl = bestFromLast ? cell[cell.size()-1-k] : cell[k];
+            double start = fromU1 ? cl.interval.u1 : cl.interval.u0;
+            double end = fromU1 ? cl.interval.u0 : cl.interval.u1;
+            ret.append(QLineF(along*start+across*cl.v,along*end+across*cl.v));
+            position = QPointF(end,cl.v);
+            fromU1 = !fromU1;
+        }
+    }
+    return ret;
+}
+
+bool SurveyLineGenerator::clipToStrip(QList<QPolygonF> const &rings, double direction, double vmin, double vmax, QList<Piece> &pieces)
+{
+    // The parts of the rings inside the strip are collected as chains running
+    // from one side of the strip to a side. Along each side, the crossings
+    // sorted by u pair up around the stretches of that side inside the area,
+    // and following chain, stretch, chain, ... closes each piece. Rings that
+    // never cross a side are kept whole and sorted into exteriors and holes.
+    pieces.clear();
+    QPointF along = alongAxis(direction);
+    QPointF across = acrossAxis(direction);
+
+    std::vector<StripChain> chains;
+    QList<QPolygonF> whole;
+    for(auto const &ring: rings)
+    {
+        int n = ring.size();
+        if(n < 3)
+            continue;
+        std::vector<double> v(n);
+        for(int i = 0; i < n; i++)
+            v[i] = dot(ring[i],across);
+        // start on a vertex outside so every chain is entered before it ends
+        int first = -1;
+        for(int i = 0; i < n && first < 0; i++)
+            if(v[i] <= vmin || v[i] >= vmax)
+                first = i;
+        if(first < 0)
+        {
+            whole.append(ring);
+            continue;
+        }
+        StripChain *chain = nullptr;
+        for(int k = 0; k < n; k++)
+        {
+            int i = (first+k)%n;
+            int j = (i+1)%n;
+            QPointF const &a = ring[i];
+            QPointF const &b = ring[j];
+            // crossings of either side, in order along the edge
+            std::vector<std::pair<double,int> > crossings;
+            if((v[i] > vmin) != (v[j] > vmin))
+                crossings.push_back(std::make_pair((vmin-v[i])/(v[j]-v[i]),0));
+            if((v[i] < vmax) != (v[j] < vmax))
+                crossings.push_back(std::make_pair((vmax-v[i])/(v[j]-v[i]),1));
+            std::sort(crossings.begin(),crossings.end());
+            for(auto const &c: crossings)
+            {
+                QPointF p = a+(b-a)*c.first;
+                if(!chain)
+                {
+                    chains.push_back(StripChain());
+                    chain = &chains.back();
+                    chain->sides[0] = c.second;
+                    chain->points << p;
+                }
+                else
+                {
+                    chain->points << p;
+                    chain->sides[1] = c.second;
+                    chain = nullptr;
+                }
+            }
+            if(chain && v[j] > vmin && v[j] < vmax)
+                chain->points << b;
+        }
+        if(chain)
+            return false;
+    }
+
+    // pair chain ends along each side
+    std::vector<int> partner(chains.size()*2,-1);
+    for(int side = 0; side < 2; side++)
+    {
+        std::vector<std::pair<double,int> > ends;
+        for(int c = 0; c < int(chains.size()); c++)
+            for(int e = 0; e < 2; e++)
+                if(chains[c].sides[e] == side)
+                {
+                    QPointF const &p = e ? chains[c].points.back() : chains[c].points.front();
+                    ends.push_back(std::make_pair(dot(p,along),c*2+e));
+                }
+        if(ends.size()%2)
+            return false;
+        std::sort(ends.begin(),ends.end());
+        for(std::size_t i = 0; i < ends.size(); i += 2)
+        {
+            partner[ends[i].second] = ends[i+1].second;
+            partner[ends[i+1].second] = ends[i].second;
+        }
+    }
+
+    QList<QPolygonF> loops;
+    std::vector<bool> used(chains.size(),false);
+    for(int c = 0; c < int(chains.size()); c++)
+    {
+        if(used[c])
+            continue;
+        QPolygonF loop;
+        int end = c*2;
+        for(std::size_t steps = 0; ; steps++)
+        {
+            if(steps > chains.size())
+                return false;
+            int chain = end/2;
+            used[chain] = true;
+            QPolygonF const &points = chains[chain].points;
+            // chains are walked from the end reached to the other one
+            if(end%2 == 0)
+                for(int i = 0; i < points.size(); i++)
+                    loop << points[i];
+            else
+                for(int i = points.size()-1; i >= 0; i--)
+                    loop << points[i];
+            end = partner[end^1];
+            if(end < 0)
+                return false;
+            if(end == c*2)
+                break;
+        }
+        loop = withoutDegenerateVertices(loop);
+        if(loop.size() > 2)
+            loops.append(loop);
+    }
+
+    // Loops of chains touch the sides, so nothing in the strip encloses them.
+    // Whole rings are holes when inside an odd number of the others.
+    int chainLoops = loops.size();
+    QList<QPolygonF> holes;
+    for(int r = 0; r < whole.size(); r++)
+    {
+        int depth = 0;
+        for(int o = 0; o < whole.size(); o++)
+            if(o != r && whole[o].containsPoint(whole[r].front(),Qt::OddEvenFill))
+                depth++;
+        for(int l = 0; l < chainLoops; l++)
+            if(loops[l].containsPoint(whole[r].front(),Qt::OddEvenFill))
+                depth++;
+        if(depth%2)
+            holes.append(whole[r]);
+        else
+            loops.append(whole[r]);
+    }
+    for(auto const &loop: loops)
+        pieces.append(Piece() << loop);
+    // each hole goes to the smallest exterior around it
+    for(auto const &hole: holes)
+    {
+        int owner = -1;
+        double ownerArea = 0.0;
+        for(int p = 0; p < pieces.size(); p++)
+            if(pieces[p].front().containsPoint(hole.front(),Qt::OddEvenFill))
+            {
+                double area = ringArea(pieces[p].front());
+                if(owner < 0 || area < ownerArea)
+                {
+                    owner = p;
+                    ownerArea = area;
+                }
+            }
+        if(owner >= 0)
+            pieces[owner].append(hole);
+    }
+    return true;
+}
+
+QList<QList<QGeoCoordinate> > SurveyLineGenerator::generate(double direction, double spacing) const
+{
+    QList<QList<QGeoCoordinate> > ret;
+    for(auto const &line: generateLocal(direction,spacing))
+    {
+        QList<QGeoCoordinate> l;
+        l.append(toGeo(line.p1()));
+        l.append(toGeo(line.p2()));
+        ret.append(l);
+    }
+    return ret;
+}
@@ -0,0 +1,61 @@
+#ifndef SURVEYLINEGENERATOR_H
+#define SURVEYLINEGENERATOR_H
+
+#include <QGeoCoordinate>
+#include <QLineF>
+#include <QPolygonF>
+#include <QList>
+#include <vector>
+
+/// Generates parallel survey lines clipped to a polygon with optional holes.
+/// Rings are converted once to a local metric frame (azimuthal equidistant about
+/// the first exterior vertex) so lines can be generated for many headings cheaply.
+class SurveyLineGenerator
+{
+public:
+    struct Interval
+    {
+        double u0;
+        double u1;
+    };
+
+    /// Intervals inside the polygon along one line, measured along the line
+    /// direction from the local origin. v is the line's offset to starboard.
+    struct Scanline
+    {
+        double v;
+        std::vector<Interval> intervals;
+    };
+
+    /// An exterior ring followed by its holes.
+    typedef QList<QPolygonF> Piece;
+
+    /// @param rings Exterior ring first, followed by any interior rings (holes).
+    explicit SurveyLineGenerator(QList<QList<QGeoCoordinate> > const &rings);
+
+    QPointF toLocal(QGeoCoordinate const &location) const;
+    QGeoCoordinate toGeo(QPointF const &point) const;
+
+    QList<QPolygonF> const &localRings() const;
+
+    /// Clips lines running along direction (degrees) spaced spacing meters apart.
+    /// Lines are grouped in boustrophedon cells and each cell is run back and forth
+    /// before moving on to a neighbouring cell.
+    QList<QLineF> generateLocal(double direction, double spacing) const;
+    QList<QList<QGeoCoordinate> > generate(double direction, double spacing) const;
+
+    std::vector<Scanline> scanlines(double direction, double spacing) const;
+
+    static QPointF alongAxis(double direction);
+    static QPointF acrossAxis(double direction);
+    /// Clips rings to the strip vmin < v < vmax across direction, one piece per
+    /// connected part. Returns false if the rings cross the strip's sides in a
+    /// way that doesn't pair up, as self-intersecting rings can.
+    static bool clipToStrip(QList<QPolygonF> const &rings, double direction, double vmin, double vmax, QList<Piece> &pieces);
+
+private:
+    QGeoCoordinate m_reference;
+    QList<QPolygonF> m_rings;
+};
+
+#endif // SURVEYLINEGENERATOR_H
@@ -0,0 +1,57 @@
+#include "surveypartitioner.h"
+#include "surveylinegenerator.h"
+#include <QtMath>
+#include <limits>
+#include <vector>
+
+QList<QList<SurveyLineGenerator::Piece> > SurveyPartitioner::partition(SurveyLineGenerator const &generator, double direction, double spacing, QList<double> const &speeds)
+{
+    QList<QList<SurveyLineGenerator::Piece> > ret;
+    if(speeds.empty())
+        return ret;
+
+    // Estimated distance of each line including the turns onto it, accumulated so
+    // cuts can be placed with one pass over the lines.
+    auto scanlines = generator.scanlines(direction,spacing);
+    std::vector<double> cumulative;
+    double total = 0.0;
+    for(auto const &scanline: scanlines)
+    {
+        for(auto const &interval: scanline.intervals)
+            total += interval.u1-interval.u0+M_PI*spacing/2.0;
+        cumulative.push_back(total);
+    }
+
+    double totalSpeed = 0.0;
+    for(auto s: speeds)
+        totalSpeed += s > 0.0 ? s : 1.0;
+
+    double vlow = -std::numeric_limits<double>::max();
+    double fraction = 0.0;
+    std::size_t line = 0;
+    for(int part = 0; part < speeds.size(); part++)
+    {
+        double vhigh = std::numeric_limits<double>::max();
+        if(part < speeds.size()-1)
+        {
+            fraction += (speeds[part] > 0.0 ? speeds[part] : 1.0)/totalSpeed;
+            double target = fraction*total;
+            while(line < cumulative.size() && cumulative[line] < target)
+                line++;
+            // cut on whichever side of the line crossing the target is closer
+            if(line > 0 && line < cumulative.size() && target-cumulative[line-1] < cumulative[line]-target)
+                line--;
+            if(line < scanlines.size())
+            {
+                vhigh = scanlines[line].v+spacing/2.0;
+                line++;
+            }
+        }
+        QList<SurveyLineGenerator::Piece> pieces;
+        if(vhigh > vlow && !SurveyLineGenerator::clipToStrip(generator.localRings(),direction,vlow,vhigh,pieces))
+            return QList<QList<SurveyLineGenerator::Piece> >();
+        ret.append(pieces);
+        vlow = vhigh;
+    }
+    return ret;
+}
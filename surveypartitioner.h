@@ -0,0 +1,20 @@
+#ifndef SURVEYPARTITIONER_H
+#define SURVEYPARTITIONER_H
+
+#include <QList>
+#include <QPolygonF>
+#include "surveylinegenerator.h"
+
+/// Splits an area into strips across the survey lines so that each vehicle's
+/// share takes about the same time to run at its own speed.
+class SurveyPartitioner
+{
+public:
+    /// Returns the local pieces of the area for each speed, in the same order.
+    /// A strip across a concave area may hold several pieces, or none if the
+    /// area has fewer lines than vehicles. Returns an empty list if the area
+    /// could not be clipped.
+    static QList<QList<SurveyLineGenerator::Piece> > partition(SurveyLineGenerator const &generator, double direction, double spacing, QList<double> const &speeds);
+};
+
+#endif // SURVEYPARTITIONER_H
@@ -0,0 +1,78 @@
+#include "symbolatlas.h"
+#include <QImage>
+#include <QPainter>
+#include <QSvgRenderer>
+#include <QtMath>
+
+SymbolAtlas::SymbolAtlas(QSvgRenderer* renderer):m_renderer(renderer)
+{
+}
+
+QSizeF SymbolAtlas::symbolSize(const QString& id) const
+{
+    return m_renderer->boundsOnElement(id).size();
+}
+
+SymbolAtlas::Atlas const &SymbolAtlas::atlas(const QString& id, qreal devicePixelRatio)
+{
+    if(!m_ids.contains(id) && m_renderer->elementExists(id))
+    {
+        // a new symbol invalidates every ratio's layout
+        m_ids.append(id);
+        m_atlases.clear();
+    }
+
+    auto existing = m_atlases.find(devicePixelRatio);
+    if(existing != m_atlases.end())
+        return existing.value();
+
+    // one row of cells with a pixel of padding so filtering never bleeds
+    QList<QRect> cells;
+    int width = 1;
+    int height = 1;
+    for(auto const &symbol: m_ids)
+    {
+        QSizeF size = symbolSize(symbol)*devicePixelRatio;
+        QRect cell(width,1,qCeil(size.width()),qCeil(size.height()));
+        cells.append(cell);
+        width += cell.width()+1;
+        height = std::max(height,cell.height()+2);
+    }
+
+    QImage image(width,height,QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    Atlas &ret = m_atlases[devicePixelRatio];
+    for(int i = 0; i < m_ids.size(); i++)
+    {
+        m_renderer->render(&painter,m_ids[i],cells[i]);
+        ret.cells[m_ids[i]] = cells[i];
+    }
+    painter.end();
+    ret.pixmap = QPixmap::fromImage(image);
+    return ret;
+}
+
+void SymbolAtlas::draw(QPainter* painter, const QString& id, const QPointF* positions, int count)
+{
+    if(count <= 0)
+        return;
+    qreal ratio = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+    Atlas const &a = atlas(id,ratio);
+    auto cell = a.cells.find(id);
+    if(cell == a.cells.end())
+        return;
+
+    // fragments are placed in device independent pixels and sized from the
+    // source rectangle, which holds ratio pixels per unit
+    QTransform transform = painter->worldTransform();
+    QVector<QPainter::PixmapFragment> fragments;
+    fragments.reserve(count);
+    for(int i = 0; i < count; i++)
+        fragments.append(QPainter::PixmapFragment::create(transform.map(positions[i]),cell.value(),1.0/ratio,1.0/ratio));
+
+    painter->save();
+    painter->resetTransform();
+    painter->drawPixmapFragments(fragments.constData(),fragments.size(),a.pixmap);
+    painter->restore();
+}
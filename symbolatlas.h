@@ -0,0 +1,40 @@
+#ifndef SYMBOLATLAS_H
+#define SYMBOLATLAS_H
+
+#include <QHash>
+#include <QMap>
+#include <QPixmap>
+#include <QStringList>
+
+class QPainter;
+class QSvgRenderer;
+
+/// Symbols from an SVG renderer, rasterized once per device pixel ratio into a
+/// shared pixmap so many copies are drawn as blits instead of SVG renders.
+class SymbolAtlas
+{
+public:
+    explicit SymbolAtlas(QSvgRenderer *renderer);
+
+    /// Size of the symbol in device independent pixels.
+    QSizeF symbolSize(QString const &id) const;
+
+    /// Draws the symbol centred on each position, given in the painter's
+    /// current coordinates. Symbols keep their size whatever the transform.
+    void draw(QPainter *painter, QString const &id, QPointF const *positions, int count);
+
+private:
+    struct Atlas
+    {
+        QPixmap pixmap;
+        QHash<QString, QRectF> cells;
+    };
+
+    QSvgRenderer *m_renderer;
+    QStringList m_ids;
+    QMap<qreal, Atlas> m_atlases;
+
+    Atlas const &atlas(QString const &id, qreal devicePixelRatio);
+};
+
+#endif // SYMBOLATLAS_H
@@ -0,0 +1,190 @@
+#include "telemetrylog.h"
+#include <QMutexLocker>
+#include <cstring>
+
+namespace
+{
+    const char magic[8] = {'A','M','P','T','L','O','G','1'};
+    const quint32 byteOrderMark = 0x01020304;
+    const qint64 chunkSize = 16*1024*1024;
+
+    struct Header
+    {
+        char magic[8];
+        quint32 byteOrder;
+        quint32 topicsSize; // bytes of newline separated topic names that follow
+    };
+
+    struct RecordHeader
+    {
+        qint64 time;
+        quint32 topic;
+        quint32 size;
+    };
+
+    Q_STATIC_ASSERT(sizeof(Header) == 16);
+    Q_STATIC_ASSERT(sizeof(RecordHeader) == 16);
+
+    qint64 aligned(qint64 offset)
+    {
+        return (offset+7) & ~qint64(7);
+    }
+}
+
+TelemetryLogWriter::TelemetryLogWriter():m_open(false),m_map(nullptr),m_mapOffset(0),m_mapSize(0),m_end(0)
+{
+}
+
+TelemetryLogWriter::~TelemetryLogWriter()
+{
+    close();
+}
+
+bool TelemetryLogWriter::open(const QString& path, const QStringList& topics)
+{
+    close();
+    QMutexLocker lock(&m_mutex);
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::ReadWrite|QIODevice::Truncate))
+        return false;
+    QByteArray names = topics.join('\n').toUtf8();
+    Header header;
+    memcpy(header.magic,magic,sizeof(magic));
+    header.byteOrder = byteOrderMark;
+    header.topicsSize = names.size();
+    m_end = aligned(sizeof(Header)+names.size());
+    QByteArray start(m_end,0);
+    memcpy(start.data(),&header,sizeof(header));
+    memcpy(start.data()+sizeof(header),names.constData(),names.size());
+    if(m_file.write(start) != start.size())
+    {
+        m_file.close();
+        return false;
+    }
+    m_open = true;
+    return true;
+}
+
+bool TelemetryLogWriter::isOpen() const
+{
+    return m_open;
+}
+
+bool TelemetryLogWriter::append(qint64 time, quint32 topic, const void* data, quint32 size)
+{
+    QMutexLocker lock(&m_mutex);
+    qint64 recordSize = aligned(sizeof(RecordHeader)+size);
+    if(!m_open || !reserve(recordSize))
+        return false;
+    RecordHeader header;
+    header.time = time;
+    header.topic = topic;
+    header.size = size;
+    uchar *p = m_map+(m_end-m_mapOffset);
+    memcpy(p+sizeof(header),data,size);
+    // the header last, so a partly written record still ends the log
+    memcpy(p,&header,sizeof(header));
+    m_end += recordSize;
+    return true;
+}
+
+void TelemetryLogWriter::close()
+{
+    QMutexLocker lock(&m_mutex);
+    if(!m_open)
+        return;
+    m_open = false;
+    if(m_map)
+        m_file.unmap(m_map);
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_file.resize(m_end);
+    m_file.close();
+}
+
+bool TelemetryLogWriter::reserve(qint64 size)
+{
+    if(m_map && m_end+size <= m_mapOffset+m_mapSize)
+        return true;
+    if(m_map)
+        m_file.unmap(m_map);
+    m_map = nullptr;
+    m_mapOffset = m_end;
+    m_mapSize = qMax(chunkSize,size);
+    if(!m_file.resize(m_mapOffset+m_mapSize))
+        return false;
+    m_map = m_file.map(m_mapOffset,m_mapSize);
+    return m_map != nullptr;
+}
+
+TelemetryLogReader::TelemetryLogReader():m_data(nullptr),m_size(0),m_first(0),m_position(0)
+{
+}
+
+bool TelemetryLogReader::open(const QString& path)
+{
+    close();
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::ReadOnly) || m_file.size() < qint64(sizeof(Header)))
+        return false;
+    m_size = m_file.size();
+    m_data = m_file.map(0,m_size);
+    if(!m_data)
+        return false;
+    Header header;
+    memcpy(&header,m_data,sizeof(header));
+    if(memcmp(header.magic,magic,sizeof(magic)) != 0 || header.byteOrder != byteOrderMark || header.topicsSize > m_size-sizeof(Header))
+    {
+        close();
+        return false;
+    }
+    QString names = QString::fromUtf8(reinterpret_cast<char const*>(m_data+sizeof(Header)),header.topicsSize);
+    if(!names.isEmpty())
+        m_topics = names.split('\n');
+    m_first = aligned(sizeof(Header)+header.topicsSize);
+    m_position = m_first;
+    return true;
+}
+
+void TelemetryLogReader::close()
+{
+    if(m_data)
+        m_file.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+    m_file.close();
+    m_size = 0;
+    m_topics.clear();
+}
+
+const QStringList & TelemetryLogReader::topics() const
+{
+    return m_topics;
+}
+
+QString TelemetryLogReader::topicName(quint32 topic) const
+{
+    if(topic < 1 || topic > quint32(m_topics.size()))
+        return QString();
+    return m_topics[topic-1];
+}
+
+bool TelemetryLogReader::next(TelemetryLogReader::Record& record)
+{
+    if(!m_data || m_position+qint64(sizeof(RecordHeader)) > m_size)
+        return false;
+    RecordHeader header;
+    memcpy(&header,m_data+m_position,sizeof(header));
+    if(header.topic == 0 || header.size > m_size-m_position-sizeof(RecordHeader))
+        return false;
+    record.time = header.time;
+    record.topic = header.topic;
+    record.size = header.size;
+    record.data = reinterpret_cast<char const*>(m_data+m_position+sizeof(RecordHeader));
+    m_position += aligned(sizeof(RecordHeader)+header.size);
+    return true;
+}
+
+void TelemetryLogReader::rewind()
+{
+    m_position = m_first;
+}
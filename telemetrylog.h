@@ -0,0 +1,74 @@
+#ifndef TELEMETRYLOG_H
+#define TELEMETRYLOG_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+
+/// Append-only binary log of timestamped telemetry messages. The header
+/// names the topics, which records refer to by number starting at 1. Each
+/// record is 8 byte aligned: time in nanoseconds since the epoch (qint64),
+/// topic (quint32), payload size (quint32), then the payload. The writer
+/// grows the file a chunk at a time and writes records into the mapped
+/// chunk; the zeros past the last record read as topic 0, which ends the
+/// log, so a log left behind by a crash is readable up to there.
+class TelemetryLogWriter
+{
+public:
+    TelemetryLogWriter();
+    ~TelemetryLogWriter();
+
+    bool open(QString const &path, QStringList const &topics);
+    bool isOpen() const;
+    /// May be called from any thread. Returns false if the log is closed.
+    bool append(qint64 time, quint32 topic, void const *data, quint32 size);
+    /// Trims the file to the records written.
+    void close();
+
+private:
+    QMutex m_mutex;
+    QFile m_file;
+    std::atomic<bool> m_open;
+    uchar *m_map;
+    qint64 m_mapOffset;
+    qint64 m_mapSize;
+    qint64 m_end;
+
+    bool reserve(qint64 size);
+};
+
+/// Reads a TelemetryLogWriter log through a read-only mapping.
+class TelemetryLogReader
+{
+public:
+    struct Record
+    {
+        qint64 time;
+        quint32 topic;
+        quint32 size;
+        char const *data; // valid while the reader is open
+    };
+
+    TelemetryLogReader();
+
+    bool open(QString const &path);
+    void close();
+    QStringList const &topics() const;
+    /// Topic name of a record, or an empty string if unknown.
+    QString topicName(quint32 topic) const;
+
+    bool next(Record &record);
+    void rewind();
+
+private:
+    QFile m_file;
+    uchar const *m_data;
+    qint64 m_size;
+    qint64 m_first;
+    qint64 m_position;
+    QStringList m_topics;
+};
+
+#endif // TELEMETRYLOG_H
@@ -0,0 +1,106 @@
+#include "telemetryqueue.h"
+
+TelemetryQueue::TelemetryQueue(int capacity):m_enqueue(0),m_dequeue(0),m_pending(false),m_dropped(0)
+{
+    quint64 size = 2;
+    while(size < quint64(capacity))
+        size *= 2;
+    m_mask = size-1;
+    m_cells.reset(new Cell[size]);
+    for(quint64 i = 0; i < size; i++)
+        m_cells[i].sequence.store(i,std::memory_order_relaxed);
+    for(int s = 0; s < StateCount; s++)
+    {
+        m_states[s].sequence.store(0,std::memory_order_relaxed);
+        for(auto &v: m_states[s].values)
+            v.store(0.0,std::memory_order_relaxed);
+        m_taken[s] = 0;
+    }
+}
+
+bool TelemetryQueue::push(const TelemetryRecord& record)
+{
+    // a cell's sequence equals the position that may write it next, and one
+    // more than that once written
+    quint64 position = m_enqueue.load(std::memory_order_relaxed);
+    Cell *cell;
+    while(true)
+    {
+        cell = &m_cells[position & m_mask];
+        qint64 difference = qint64(cell->sequence.load(std::memory_order_acquire)-position);
+        if(difference == 0)
+        {
+            if(m_enqueue.compare_exchange_weak(position,position+1,std::memory_order_relaxed))
+                break;
+        }
+        else if(difference < 0)
+        {
+            m_dropped.fetch_add(1,std::memory_order_relaxed);
+            return false;
+        }
+        else
+            position = m_enqueue.load(std::memory_order_relaxed);
+    }
+    cell->record = record;
+    cell->sequence.store(position+1,std::memory_order_release);
+    return true;
+}
+
+bool TelemetryQueue::pop(TelemetryRecord& record)
+{
+    Cell &cell = m_cells[m_dequeue & m_mask];
+    if(cell.sequence.load(std::memory_order_acquire) != m_dequeue+1)
+        return false;
+    record = cell.record;
+    cell.sequence.store(m_dequeue+m_mask+1,std::memory_order_release);
+    m_dequeue++;
+    return true;
+}
+
+void TelemetryQueue::setState(TelemetryQueue::State state, double a, double b, double c)
+{
+    // sequence lock: odd while the values are being written
+    StateSlot &slot = m_states[state];
+    quint32 sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence+1,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.values[0].store(a,std::memory_order_relaxed);
+    slot.values[1].store(b,std::memory_order_relaxed);
+    slot.values[2].store(c,std::memory_order_relaxed);
+    slot.sequence.store(sequence+2,std::memory_order_release);
+}
+
+bool TelemetryQueue::takeState(TelemetryQueue::State state, double& a, double& b, double& c)
+{
+    StateSlot &slot = m_states[state];
+    quint32 before, after;
+    do
+    {
+        before = slot.sequence.load(std::memory_order_acquire);
+        if(before == m_taken[state])
+            return false;
+        a = slot.values[0].load(std::memory_order_relaxed);
+        b = slot.values[1].load(std::memory_order_relaxed);
+        c = slot.values[2].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = slot.sequence.load(std::memory_order_relaxed);
+    } while((before & 1) || before != after);
+    m_taken[state] = before;
+    return true;
+}
+
+bool TelemetryQueue::markPending()
+{
+    return !m_pending.exchange(true,std::memory_order_acq_rel);
+}
+
+void TelemetryQueue::startDrain()
+{
+    // a read-modify-write, so records pushed before the flag was set are seen
+    m_pending.exchange(false,std::memory_order_acq_rel);
+}
+
+quint64 TelemetryQueue::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,91 @@
+#ifndef TELEMETRYQUEUE_H
+#define TELEMETRYQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include "aiscontactstore.h"
+
+/// A fixed size telemetry sample. Position topics use latitude, longitude
+/// and altitude; AIS contacts carry their report.
+struct TelemetryRecord
+{
+    enum Topic
+    {
+        Location,
+        PosmvLocation,
+        BaseLocation,
+        AISContact
+    };
+
+    Topic topic;
+    double latitude;
+    double longitude;
+    double altitude;
+    AISContactReport contact;
+};
+
+/// Hands telemetry from the ROS spinner threads to the GUI thread without
+/// locks or allocation. Samples that each matter, such as positions, go
+/// through a bounded multi-producer ring of preallocated records. State-like
+/// topics, such as heading, keep only their latest value, which a newer
+/// sample overwrites before the consumer gets to it. Any thread may produce;
+/// only one thread consumes. A state topic must have a single writer at a
+/// time, which holds for ROS subscriptions.
+class TelemetryQueue
+{
+public:
+    enum State
+    {
+        Heading,
+        PosmvHeading,
+        BaseHeading,
+        Origin, // latitude, longitude, altitude
+        Sog,
+        StateCount
+    };
+
+    /// Capacity is rounded up to a power of two.
+    explicit TelemetryQueue(int capacity = 4096);
+
+    /// Returns false, dropping the record, when the ring is full.
+    bool push(TelemetryRecord const &record);
+    bool pop(TelemetryRecord &record);
+
+    void setState(State state, double a, double b = 0.0, double c = 0.0);
+    /// True with the latest values if the state was set since last taken.
+    bool takeState(State state, double &a, double &b, double &c);
+
+    /// Returns true for the first producer to call it since the consumer
+    /// last called startDrain(); that producer is the one to wake the
+    /// consumer.
+    bool markPending();
+    void startDrain();
+
+    quint64 dropped() const;
+
+private:
+    struct Cell
+    {
+        std::atomic<quint64> sequence;
+        TelemetryRecord record;
+    };
+
+    struct StateSlot
+    {
+        std::atomic<quint32> sequence;
+        std::atomic<double> values[3];
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    quint64 m_mask;
+    std::atomic<quint64> m_enqueue;
+    char m_padding[64]; // keeps the producers off the consumer's cache line
+    quint64 m_dequeue;
+    StateSlot m_states[StateCount];
+    quint32 m_taken[StateCount];
+    std::atomic<bool> m_pending;
+    std::atomic<quint64> m_dropped;
+};
+
+#endif // TELEMETRYQUEUE_H
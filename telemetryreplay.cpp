@@ -0,0 +1,69 @@
+#include "telemetryreplay.h"
+#include <algorithm>
+#include <chrono>
+
+TelemetryReplay::TelemetryReplay(QObject* parent):QObject(parent),m_speed(1.0),m_stop(false),m_running(false)
+{
+}
+
+TelemetryReplay::~TelemetryReplay()
+{
+    stop();
+}
+
+bool TelemetryReplay::start(const QString& path, double speed, const Handler& handler)
+{
+    stop();
+    if(!m_reader.open(path))
+        return false;
+    m_speed = speed;
+    m_handler = handler;
+    m_stop = false;
+    m_running = true;
+    m_thread = std::thread(&TelemetryReplay::run,this);
+    return true;
+}
+
+void TelemetryReplay::stop()
+{
+    m_stop = true;
+    if(m_thread.joinable())
+        m_thread.join();
+    m_reader.close();
+}
+
+bool TelemetryReplay::isRunning() const
+{
+    return m_running;
+}
+
+void TelemetryReplay::run()
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    qint64 first = 0;
+    bool haveFirst = false;
+    TelemetryLogReader::Record record;
+    while(!m_stop && m_reader.next(record))
+    {
+        if(!haveFirst)
+        {
+            first = record.time;
+            haveFirst = true;
+        }
+        if(m_speed > 0.0)
+        {
+            Clock::time_point due = start+std::chrono::nanoseconds(qint64((record.time-first)/m_speed));
+            // short naps so stop() is not kept waiting across long gaps
+            while(!m_stop && Clock::now() < due)
+                std::this_thread::sleep_until(std::min(due,Clock::now()+std::chrono::milliseconds(100)));
+            if(m_stop)
+                break;
+        }
+        QString topic = m_reader.topicName(record.topic);
+        if(!topic.isEmpty())
+            m_handler(record.time,topic,record.data,record.size);
+    }
+    m_running = false;
+    emit finished();
+}
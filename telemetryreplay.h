@@ -0,0 +1,45 @@
+#ifndef TELEMETRYREPLAY_H
+#define TELEMETRYREPLAY_H
+
+#include <QObject>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include "telemetrylog.h"
+
+/// Plays a telemetry log back on its own thread, handing each record and the
+/// time it was recorded to a handler, with the spacing it was recorded with
+/// scaled by speed. A speed of 1 is real time, N is N times faster and 0 or
+/// less is as fast as the handler keeps up, which makes a repeatable load
+/// test.
+class TelemetryReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// time is in nanoseconds since the epoch.
+    typedef std::function<void(qint64 time, QString const &topic, char const *data, quint32 size)> Handler;
+
+    explicit TelemetryReplay(QObject *parent = nullptr);
+    ~TelemetryReplay();
+
+    bool start(QString const &path, double speed, Handler const &handler);
+    void stop();
+    bool isRunning() const;
+
+signals:
+    /// Emitted from the replay thread once the log has been played or stopped.
+    void finished();
+
+private:
+    TelemetryLogReader m_reader;
+    double m_speed;
+    Handler m_handler;
+    std::thread m_thread;
+    std::atomic<bool> m_stop;
+    std::atomic<bool> m_running;
+
+    void run();
+};
+
+#endif // TELEMETRYREPLAY_H
@@ -0,0 +1,150 @@
+#include "trackhistory.h"
+#include <algorithm>
+
+namespace
+{
+    const int chunkSize = 64;
+
+    void grow(QRectF &r, QPointF const &p)
+    {
+        r.setLeft(std::min(r.left(),p.x()));
+        r.setRight(std::max(r.right(),p.x()));
+        r.setTop(std::min(r.top(),p.y()));
+        r.setBottom(std::max(r.bottom(),p.y()));
+    }
+}
+
+TrackHistory::TrackHistory(int capacity):m_entries(std::max(1,capacity)),m_first(0),m_size(0),m_dropped(0)
+{
+}
+
+int TrackHistory::capacity() const
+{
+    return m_entries.size();
+}
+
+int TrackHistory::size() const
+{
+    return m_size;
+}
+
+bool TrackHistory::empty() const
+{
+    return m_size == 0;
+}
+
+void TrackHistory::clear()
+{
+    m_first = 0;
+    m_size = 0;
+    m_chunks.clear();
+    m_dropped = 0;
+}
+
+void TrackHistory::append(const QGeoCoordinate& location, const QPointF& position)
+{
+    int capacity = m_entries.size();
+    Entry &e = m_entries[(m_first+m_size)%capacity];
+    e.latitude = location.latitude();
+    e.longitude = location.longitude();
+    e.position = position;
+    if(m_size < capacity)
+        m_size++;
+    else
+    {
+        m_first = (m_first+1)%capacity;
+        m_dropped++;
+        if(!m_chunks.empty() && m_dropped >= m_chunks.front().count)
+        {
+            m_dropped -= m_chunks.front().count;
+            m_chunks.pop_front();
+        }
+    }
+    extendPath(position);
+}
+
+void TrackHistory::extendPath(const QPointF& position)
+{
+    if(m_chunks.empty() || m_chunks.back().count >= chunkSize)
+    {
+        Chunk c;
+        if(m_chunks.empty())
+        {
+            c.path.moveTo(position);
+            c.bounds = QRectF(position,position);
+        }
+        else
+        {
+            // continue from where the previous chunk ended
+            QPointF start = m_chunks.back().path.currentPosition();
+            c.path.moveTo(start);
+            c.bounds = QRectF(start,start);
+            c.path.lineTo(position);
+            grow(c.bounds,position);
+        }
+        c.count = 1;
+        m_chunks.push_back(c);
+        return;
+    }
+    Chunk &c = m_chunks.back();
+    c.path.lineTo(position);
+    grow(c.bounds,position);
+    c.count++;
+}
+
+TrackHistory::Entry const & TrackHistory::entry(int i) const
+{
+    return m_entries[(m_first+i)%m_entries.size()];
+}
+
+QGeoCoordinate TrackHistory::location(int i) const
+{
+    Entry const &e = entry(i);
+    return QGeoCoordinate(e.latitude,e.longitude);
+}
+
+QPointF const & TrackHistory::position(int i) const
+{
+    return entry(i).position;
+}
+
+QPointF const & TrackHistory::lastPosition() const
+{
+    return entry(m_size-1).position;
+}
+
+void TrackHistory::reproject(std::function<QPointF(QGeoCoordinate const &)> const &project)
+{
+    for(int i = 0; i < m_size; i++)
+    {
+        Entry &e = m_entries[(m_first+i)%m_entries.size()];
+        e.position = project(QGeoCoordinate(e.latitude,e.longitude));
+    }
+    m_chunks.clear();
+    m_dropped = 0;
+    for(int i = 0; i < m_size; i++)
+        extendPath(position(i));
+}
+
+int TrackHistory::pathCount() const
+{
+    return m_chunks.size();
+}
+
+QPainterPath const & TrackHistory::path(int i) const
+{
+    return m_chunks[i].path;
+}
+
+QRectF TrackHistory::bounds() const
+{
+    if(m_chunks.empty())
+        return QRectF();
+    QRectF ret = m_chunks.front().bounds;
+    for(auto const &c: m_chunks)
+    {
+        grow(ret,c.bounds.topLeft());
+        grow(ret,c.bounds.bottomRight());
+    }
+    return ret;
+}
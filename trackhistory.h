@@ -0,0 +1,73 @@
+#ifndef TRACKHISTORY_H
+#define TRACKHISTORY_H
+
+#include <QGeoCoordinate>
+#include <QPainterPath>
+#include <QPointF>
+#include <deque>
+#include <functional>
+#include <vector>
+
+/// Fixed capacity ring buffer of the most recent positions of a track. Each
+/// entry keeps its geographic position next to its projected one in a single
+/// contiguous block, so memory stays constant however long the track runs and
+/// reprojecting never touches more than capacity entries.
+///
+/// The projected track is also kept as a run of short painter paths that grow
+/// as positions arrive and are dropped whole once all of their positions have
+/// left the buffer, so a new position costs the same however long the track
+/// is. The oldest path may still show a few positions already dropped.
+class TrackHistory
+{
+public:
+    explicit TrackHistory(int capacity);
+
+    int capacity() const;
+    int size() const;
+    bool empty() const;
+    void clear();
+
+    /// Adds a position, dropping the oldest one when full.
+    void append(QGeoCoordinate const &location, QPointF const &position);
+
+    /// Entry i counted from the oldest.
+    QGeoCoordinate location(int i) const;
+    QPointF const &position(int i) const;
+    QPointF const &lastPosition() const;
+
+    /// Recomputes every projected position from its geographic one.
+    void reproject(std::function<QPointF(QGeoCoordinate const &)> const &project);
+
+    int pathCount() const;
+    QPainterPath const &path(int i) const;
+    /// Bounds of all paths.
+    QRectF bounds() const;
+
+private:
+    struct Entry
+    {
+        double latitude;
+        double longitude;
+        QPointF position;
+    };
+
+    struct Chunk
+    {
+        QPainterPath path;
+        QRectF bounds;
+        // positions this chunk added, not counting the one it starts from
+        int count;
+    };
+
+    std::vector<Entry> m_entries;
+    int m_first;
+    int m_size;
+    std::deque<Chunk> m_chunks;
+    // positions of the front chunk already overwritten in the buffer
+    int m_dropped;
+
+    Entry const &entry(int i) const;
+    void extendPath(QPointF const &position);
+};
+
+#endif // TRACKHISTORY_H
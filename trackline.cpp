@@ -85,6 +85,7 @@ Waypoint * TrackLine::createWaypoint()
     wp->setFlag(QGraphicsItem::ItemIsSelectable);
     wp->setFlag(QGraphicsItem::ItemSendsGeometryChanges);
     wp->setFlag(QGraphicsItem::ItemSendsScenePositionChanges);
+    connect(wp, &Waypoint::waypointMoved, this, &TrackLine::trackLineUpdated);
     return wp;
 }
 
@@ -0,0 +1,251 @@
+#include "vectorcache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    const char magic[8] = {'A','M','P','V','E','C','T','1'};
+    const quint32 byteOrderMark = 0x01020304;
+    const quint32 version = 1;
+
+    // Least recently used entries are removed once the cache grows past this.
+    const qint64 maxCacheSize = qint64(512)*1024*1024;
+
+    struct Header
+    {
+        char magic[8];
+        quint32 byteOrder;
+        quint32 version;
+        quint64 layerCount;
+        quint64 reserved;
+    };
+
+    struct LayerEntry
+    {
+        quint64 nameOffset;
+        quint64 nameSize;
+        quint64 featureCount;
+        quint64 ringCount;
+        quint64 coordinateCount;
+        quint64 typesOffset;
+        quint64 featureOffsetsOffset;
+        quint64 ringOffsetsOffset;
+        quint64 ringHolesOffset;
+        quint64 coordinatesOffset;
+        quint64 boundsOffset;
+    };
+
+    Q_STATIC_ASSERT(sizeof(QPointF) == 2*sizeof(double));
+    Q_STATIC_ASSERT(sizeof(int) == sizeof(qint32));
+    Q_STATIC_ASSERT(sizeof(PackedGeometry::FeatureType) == 1);
+
+    quint64 aligned(quint64 offset)
+    {
+        return (offset+7) & ~quint64(7);
+    }
+
+    // Reserves an 8 byte aligned block and returns its offset.
+    quint64 allocate(quint64 &end, quint64 size)
+    {
+        quint64 ret = aligned(end);
+        end = ret+size;
+        return ret;
+    }
+
+    bool writeAt(QSaveFile &file, quint64 offset, void const *data, quint64 size)
+    {
+        if(size == 0)
+            return true;
+        return file.seek(offset) && file.write(static_cast<char const*>(data),size) == qint64(size);
+    }
+
+    // west, south, east, north of every feature
+    std::vector<double> featureBounds(PackedGeometry const &features)
+    {
+        std::vector<double> ret;
+        ret.reserve(features.featureCount()*4);
+        for(int f = 0; f < features.featureCount(); f++)
+        {
+            double west = std::numeric_limits<double>::max();
+            double south = west;
+            double east = -west;
+            double north = -west;
+            int begin = features.firstCoordinate(features.firstRing(f));
+            int end = features.firstCoordinate(features.firstRing(f)+features.ringCount(f));
+            for(int i = begin; i < end; i++)
+            {
+                QPointF const &c = features.coordinate(i);
+                west = std::min(west,c.x());
+                east = std::max(east,c.x());
+                south = std::min(south,c.y());
+                north = std::max(north,c.y());
+            }
+            ret.push_back(west);
+            ret.push_back(south);
+            ret.push_back(east);
+            ret.push_back(north);
+        }
+        return ret;
+    }
+
+    // Entries are sorted newest first, reads refresh the modification time,
+    // so whatever is left over the limit is the least recently used.
+    void prune(QString const &dir)
+    {
+        QFileInfoList entries = QDir(dir).entryInfoList(QStringList("*.ampv"),QDir::Files,QDir::Time);
+        qint64 total = 0;
+        for(QFileInfo const &entry: entries)
+        {
+            total += entry.size();
+            if(total > maxCacheSize)
+                QFile::remove(entry.absoluteFilePath());
+        }
+    }
+
+    template<typename T> bool copyArray(uchar const *base, quint64 fileSize, quint64 offset, quint64 count, std::vector<T> &ret)
+    {
+        ret.resize(0);
+        if(count == 0)
+            return true;
+        if(offset > fileSize || count > (fileSize-offset)/sizeof(T))
+            return false;
+        ret.resize(count);
+        memcpy(ret.data(),base+offset,count*sizeof(T));
+        return true;
+    }
+}
+
+QString VectorCache::cachePath(const QString& datasetPath)
+{
+    QFileInfo info(datasetPath);
+    QByteArray key = info.absoluteFilePath().toUtf8();
+    key += QByteArray::number(info.size());
+    key += QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)+"/vectors";
+    return dir+"/"+QCryptographicHash::hash(key,QCryptographicHash::Sha1).toHex()+".ampv";
+}
+
+bool VectorCache::write(const QString& path, const std::vector<Layer>& layers)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    Header header;
+    memcpy(header.magic,magic,sizeof(magic));
+    header.byteOrder = byteOrderMark;
+    header.version = version;
+    header.layerCount = layers.size();
+    header.reserved = 0;
+
+    quint64 end = sizeof(Header)+layers.size()*sizeof(LayerEntry);
+    bool ok = writeAt(file,0,&header,sizeof(header));
+    for(std::size_t l = 0; l < layers.size() && ok; l++)
+    {
+        PackedGeometry const &g = layers[l].features;
+        QByteArray name = layers[l].name.toUtf8();
+        std::vector<double> bounds = featureBounds(g);
+
+        LayerEntry entry;
+        entry.featureCount = g.featureCount();
+        entry.ringCount = g.m_ringHoles.size();
+        entry.coordinateCount = g.m_coordinates.size();
+        entry.nameSize = name.size();
+        entry.nameOffset = allocate(end,name.size());
+        entry.typesOffset = allocate(end,g.m_featureTypes.size());
+        entry.featureOffsetsOffset = allocate(end,g.m_featureOffsets.size()*sizeof(qint32));
+        entry.ringOffsetsOffset = allocate(end,g.m_ringOffsets.size()*sizeof(qint32));
+        entry.ringHolesOffset = allocate(end,g.m_ringHoles.size());
+        entry.coordinatesOffset = allocate(end,g.m_coordinates.size()*sizeof(QPointF));
+        entry.boundsOffset = allocate(end,bounds.size()*sizeof(double));
+
+        ok = writeAt(file,sizeof(Header)+l*sizeof(LayerEntry),&entry,sizeof(entry)) &&
+             writeAt(file,entry.nameOffset,name.constData(),name.size()) &&
+             writeAt(file,entry.typesOffset,g.m_featureTypes.data(),g.m_featureTypes.size()) &&
+             writeAt(file,entry.featureOffsetsOffset,g.m_featureOffsets.data(),g.m_featureOffsets.size()*sizeof(qint32)) &&
+             writeAt(file,entry.ringOffsetsOffset,g.m_ringOffsets.data(),g.m_ringOffsets.size()*sizeof(qint32)) &&
+             writeAt(file,entry.ringHolesOffset,g.m_ringHoles.data(),g.m_ringHoles.size()) &&
+             writeAt(file,entry.coordinatesOffset,g.m_coordinates.data(),g.m_coordinates.size()*sizeof(QPointF)) &&
+             writeAt(file,entry.boundsOffset,bounds.data(),bounds.size()*sizeof(double));
+    }
+    if(!ok)
+    {
+        file.cancelWriting();
+        return false;
+    }
+    if(!file.commit())
+        return false;
+    prune(QFileInfo(path).absolutePath());
+    return true;
+}
+
+bool VectorCache::read(const QString& path, std::vector<Layer>& layers, QGeoRectangle const &area)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly) || quint64(file.size()) < sizeof(Header))
+        return false;
+    quint64 size = file.size();
+    uchar const *base = file.map(0,size);
+    if(!base)
+        return false;
+
+    Header header;
+    memcpy(&header,base,sizeof(header));
+    if(memcmp(header.magic,magic,sizeof(magic)) != 0 || header.byteOrder != byteOrderMark || header.version != version ||
+        header.layerCount > (size-sizeof(Header))/sizeof(LayerEntry))
+        return false;
+
+    layers.clear();
+    layers.resize(header.layerCount);
+    for(quint64 l = 0; l < header.layerCount; l++)
+    {
+        LayerEntry entry;
+        memcpy(&entry,base+sizeof(Header)+l*sizeof(LayerEntry),sizeof(entry));
+        if(entry.nameOffset > size || entry.nameSize > size-entry.nameOffset)
+            return false;
+        layers[l].name = QString::fromUtf8(reinterpret_cast<char const*>(base+entry.nameOffset),entry.nameSize);
+
+        PackedGeometry &g = layers[l].features;
+        if(!copyArray(base,size,entry.typesOffset,entry.featureCount,g.m_featureTypes) ||
+            !copyArray(base,size,entry.featureOffsetsOffset,entry.featureCount+1,g.m_featureOffsets) ||
+            !copyArray(base,size,entry.ringOffsetsOffset,entry.ringCount+1,g.m_ringOffsets) ||
+            !copyArray(base,size,entry.ringHolesOffset,entry.ringCount,g.m_ringHoles) ||
+            !copyArray(base,size,entry.coordinatesOffset,entry.coordinateCount,g.m_coordinates))
+            return false;
+        if(quint64(g.m_featureOffsets.back()) != entry.ringCount || quint64(g.m_ringOffsets.back()) != entry.coordinateCount)
+            return false;
+
+        if(area.isValid())
+        {
+            std::vector<double> bounds;
+            if(!copyArray(base,size,entry.boundsOffset,entry.featureCount*4,bounds))
+                return false;
+            double west = area.topLeft().longitude();
+            double east = area.bottomRight().longitude();
+            double south = area.bottomRight().latitude();
+            double north = area.topLeft().latitude();
+            PackedGeometry selected;
+            for(int f = 0; f < g.featureCount(); f++)
+            {
+                double const *b = &bounds[f*4];
+                if(b[0] > east || b[2] < west || b[1] > north || b[3] < south)
+                    continue;
+                selected.appendFeature(g,f);
+            }
+            g = selected;
+        }
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    file.setFileTime(QDateTime::currentDateTime(),QFileDevice::FileModificationTime);
+#endif
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef VECTORCACHE_H
+#define VECTORCACHE_H
+
+#include <QString>
+#include <QGeoRectangle>
+#include <vector>
+#include "packedgeometry.h"
+
+/// Binary cache of a vector dataset's features, already unprojected to WGS84.
+/// Each layer's packed arrays are stored 8 byte aligned next to a per-feature
+/// bounding box table, so a memory mapped file is read back with plain copies.
+class VectorCache
+{
+public:
+    struct Layer
+    {
+        QString name;
+        PackedGeometry features;
+    };
+
+    /// Where the cache for a dataset lives. The name depends on the dataset's
+    /// path, size and modification time, so stale entries are never found.
+    static QString cachePath(QString const &datasetPath);
+
+    /// Writes the layers, then trims the cache directory to its size limit by
+    /// removing the least recently used entries.
+    static bool write(QString const &path, std::vector<Layer> const &layers);
+
+    /// Reads all layers, keeping only the features whose bounding boxes overlap
+    /// area when it is valid. Returns false if the file is missing or unusable.
+    static bool read(QString const &path, std::vector<Layer> &layers, QGeoRectangle const &area = QGeoRectangle());
+};
+
+#endif // VECTORCACHE_H
@@ -1,20 +1,24 @@
 #include "vectordataset.h"
 #include <gdal_priv.h>
 #include "group.h"
-#include "point.h"
-#include "linestring.h"
+#include "vectorlayer.h"
 #include "backgroundraster.h"
-#include "polygon.h"
 #include "autonomousvehicleproject.h"
 #include <ogrsf_frmts.h>
 #include <QDebug>
 #include <QStandardItem>
+#include <QThread>
 
-VectorDataset::VectorDataset(MissionItem* parent):Group(parent)
+VectorDataset::VectorDataset(MissionItem* parent):Group(parent),m_loaderThread(nullptr),m_loader(nullptr)
 {
 }
 
-void VectorDataset::open(const QString& fname)
+VectorDataset::~VectorDataset()
+{
+    stopLoader();
+}
+
+void VectorDataset::open(const QString& fname, QGeoRectangle const &area)
 {
     if(!fname.isEmpty())
         m_filename = fname;
@@ -23,117 +27,86 @@ void VectorDataset::open(const QString& fname)
     if (dataset)
     {
         extractGeoreference(dataset);
-        for(int i = 0; i < dataset->GetLayerCount(); ++i)
-        {
-            OGRLayer *layer = dataset->GetLayer(i);
-            OGRCoordinateTransformation *unprojectTransformation = nullptr;
-            OGRSpatialReference *projected = layer->GetSpatialRef();
-            if(projected)
-            {
-                OGRSpatialReference wgs84;
-                wgs84.SetWellKnownGeogCS("WGS84");
-                unprojectTransformation = OGRCreateCoordinateTransformation(projected,&wgs84);
-            }
-
-            Group *group = new Group(this);
-            group->setObjectName(layer->GetName());
-            layer->ResetReading();
-            OGRFeature * feature = layer->GetNextFeature();
-            while(feature)
-            {
-                OGRGeometry * geometry = feature->GetGeometryRef();
-                if(geometry)
-                {
-                    OGRwkbGeometryType gtype = geometry->getGeometryType();
-                    if(gtype == wkbPoint)
-                    {
-                        OGRPoint *op = dynamic_cast<OGRPoint*>(geometry);
-                        Point *p = new Point(group);
-                        QGeoCoordinate location(op->getY(),op->getX());
-                        if(unprojectTransformation)
-                        {
-                            double x = op->getX();
-                            double y = op->getY();
-                            unprojectTransformation->Transform(1,&x,&y);
-                            location.setLatitude(y);
-                            location.setLongitude(x);
-                        }
-                        p->setLocation(location);
-                        p->setObjectName("point");
-                    }
-                    else if(gtype == wkbLineString)
-                    {
-                        OGRLineString *ols = dynamic_cast<OGRLineString*>(geometry);
-                        LineString *ls = new LineString(group);
-                        ls->setObjectName("lineString");
-                        OGRPointIterator *pi = ols->getPointIterator();
-                        OGRPoint p;
-                        while(pi->getNextPoint(&p))
-                        {
-                            if(unprojectTransformation)
-                            {
-                                double x = p.getX();
-                                double y = p.getY();
-                                unprojectTransformation->Transform(1,&x,&y);
-                                p.setX(x);
-                                p.setY(y);
-                            }
-                            QGeoCoordinate location(p.getY(),p.getX());
-                            ls->addPoint(location);
-                        }                        
-                    }
-                    else if(gtype == wkbPolygon)
-                    {
-                        OGRPolygon *op = dynamic_cast<OGRPolygon*>(geometry);
-                        Polygon *p = new Polygon(group);
-                        p->setObjectName("polygon");
-                        OGRLinearRing *lr = op->getExteriorRing();
-                        qDebug() << "polygon exterior ring point count " << lr->getNumPoints();
-                        OGRPointIterator *pi = lr->getPointIterator();
-                        OGRPoint pt;
-                        while(pi->getNextPoint(&pt))
-                        {
-                            if(unprojectTransformation)
-                            {
-                                double x = pt.getX();
-                                double y = pt.getY();
-                                unprojectTransformation->Transform(1,&x,&y);
-                                pt.setX(x);
-                                pt.setY(y);
-                            }
-                            QGeoCoordinate location(pt.getY(),pt.getX());
-                            p->addExteriorPoint(location);
-                        }                        
-                        for(int ringNum = 0; ringNum < op->getNumInteriorRings(); ringNum++)
-                        {
-                            p->addInteriorRing();
-                            lr = op->getInteriorRing(ringNum);
-                            pi = lr->getPointIterator();
-                            while(pi->getNextPoint(&pt))
-                            {
-                                if(unprojectTransformation)
-                                {
-                                    double x = pt.getX();
-                                    double y = pt.getY();
-                                    unprojectTransformation->Transform(1,&x,&y);
-                                    pt.setX(x);
-                                    pt.setY(y);
-                                }
-                                QGeoCoordinate location(pt.getY(),pt.getX());
-                                p->addInteriorPoint(location);
-                            }                        
-                        }
-                        p->updateBBox();
-                        connect(autonomousVehicleProject(),&AutonomousVehicleProject::backgroundUpdated,p,&Polygon::updateBackground);
-                    }
-                    else
-                        qDebug() << "type: " << gtype;
-                }
-                OGRFeature::DestroyFeature(feature);
-                feature = layer->GetNextFeature();
-            }
-        }
+
+        // The loader owns the dataset from here on and only touches it from its thread.
+        m_loader = new VectorDatasetLoader(dataset);
+        m_loader->setAreaOfInterest(area);
+        m_loader->setCachePath(VectorCache::cachePath(m_filename));
+        m_loaderThread = new QThread();
+        m_loader->moveToThread(m_loaderThread);
+        connect(m_loaderThread, &QThread::started, m_loader, &VectorDatasetLoader::run);
+        connect(m_loader, &VectorDatasetLoader::layerStarted, this, &VectorDataset::addLayer);
+        connect(m_loader, &VectorDatasetLoader::batchReady, this, &VectorDataset::addFeatures);
+        connect(m_loader, &VectorDatasetLoader::progress, this, &VectorDataset::loadProgress);
+        connect(m_loader, &VectorDatasetLoader::finished, this, &VectorDataset::onLoaderFinished);
+        m_loaderThread->start();
     }
+    else
+        emit loadFinished();
+}
+
+bool VectorDataset::loading() const
+{
+    return m_loader != nullptr;
+}
+
+void VectorDataset::cancelLoading()
+{
+    if(m_loader)
+    {
+        stopLoader();
+        buildIndices();
+        emit loadFinished();
+    }
+}
+
+void VectorDataset::buildIndices()
+{
+    for(auto layer: m_layers)
+        if(layer)
+            layer->buildIndex();
+}
+
+void VectorDataset::stopLoader()
+{
+    if(m_loader)
+    {
+        m_loader->cancel();
+        m_loaderThread->quit();
+        m_loaderThread->wait();
+        delete m_loader;
+        m_loader = nullptr;
+        delete m_loaderThread;
+        m_loaderThread = nullptr;
+    }
+}
+
+void VectorDataset::onLoaderFinished()
+{
+    if(!m_loader)
+        return;
+    stopLoader();
+    buildIndices();
+    emit loadFinished();
+}
+
+void VectorDataset::addLayer(int layer, const QString& name)
+{
+    if(!m_loader)
+        return;
+    VectorLayer *vl = createMissionItem<VectorLayer>(name);
+    connect(autonomousVehicleProject(),&AutonomousVehicleProject::backgroundUpdated,vl,&VectorLayer::updateBackground);
+    while(m_layers.size() <= layer)
+        m_layers.append(nullptr);
+    m_layers[layer] = vl;
+}
+
+void VectorDataset::addFeatures(int layer, const PackedGeometry& features)
+{
+    // batches still queued when loading was cancelled are dropped
+    if(!m_loader || layer >= m_layers.size() || !m_layers[layer])
+        return;
+    m_layers[layer]->addFeatures(features);
 }
 
 void VectorDataset::write(QJsonObject& json) const
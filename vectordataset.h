@@ -3,6 +3,10 @@
 
 #include "georeferenced.h"
 #include "group.h"
+#include "vectordatasetloader.h"
+
+class QThread;
+class VectorLayer;
 
 class VectorDataset :public Group, public Georeferenced
 {
@@ -10,17 +14,41 @@ class VectorDataset :public Group, public Georeferenced
     
 public:
     VectorDataset(MissionItem *parent = 0);
+    ~VectorDataset();
     
     void write(QJsonObject &json) const;
     void read(const QJsonObject &json);
     
-    void open(const QString &fname);
+    /// Starts reading features in the background. Each layer gets a tree item
+    /// and its features are added to it in batches as they arrive. A valid area
+    /// limits the import to features overlapping it.
+    void open(const QString &fname, QGeoRectangle const &area = QGeoRectangle());
+    
+    bool loading() const;
+    
+signals:
+    void loadProgress(qint64 featuresRead, qint64 featureCount);
+    void loadFinished();
     
 public slots:
     void updateProjectedPoints() override;
     
+    /// Stops a load in progress, keeping the features already added.
+    void cancelLoading();
+    
+private slots:
+    void addLayer(int layer, QString const &name);
+    void addFeatures(int layer, PackedGeometry const &features);
+    void onLoaderFinished();
+    
 private:
     QString m_filename;
+    QList<VectorLayer *> m_layers;
+    QThread *m_loaderThread;
+    VectorDatasetLoader *m_loader;
+    
+    void stopLoader();
+    void buildIndices();
 };
 
 #endif // VECTORDATASET_H
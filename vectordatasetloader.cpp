@@ -0,0 +1,384 @@
+#include "vectordatasetloader.h"
+#include <gdal_priv.h>
+#include <ogrsf_frmts.h>
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // GDAL 3 follows the authority's latitude first axis order unless told otherwise.
+    void setWGS84(OGRSpatialReference &srs)
+    {
+        srs.SetWellKnownGeogCS("WGS84");
+#if GDAL_VERSION_MAJOR >= 3
+        srs.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+    }
+
+    void readCurve(OGRSimpleCurve *curve, PackedGeometry &geometry, bool hole = false)
+    {
+        geometry.addRing(hole);
+        int count = curve->getNumPoints();
+        for(int i = 0; i < count; i++)
+            geometry.addCoordinate(curve->getX(i),curve->getY(i));
+    }
+
+    // Appends the parts of geometry of the given type, recursing into multi
+    // geometries and collections. The feature is only started once a part is
+    // found, so a collection yields at most one feature per type.
+    void readParts(OGRGeometry *geometry, PackedGeometry::FeatureType type, PackedGeometry &batch, bool &started)
+    {
+        if(geometry->IsEmpty())
+            return;
+        OGRwkbGeometryType gtype = wkbFlatten(geometry->getGeometryType());
+        PackedGeometry::FeatureType partType;
+        if(gtype == wkbPoint)
+            partType = PackedGeometry::PointFeature;
+        else if(gtype == wkbLineString || gtype == wkbLinearRing)
+            partType = PackedGeometry::LineStringFeature;
+        else if(gtype == wkbPolygon)
+            partType = PackedGeometry::PolygonFeature;
+        else
+        {
+            if(OGR_GT_IsSubClassOf(gtype,wkbGeometryCollection))
+            {
+                OGRGeometryCollection *collection = static_cast<OGRGeometryCollection*>(geometry);
+                for(int i = 0; i < collection->getNumGeometries(); i++)
+                    readParts(collection->getGeometryRef(i),type,batch,started);
+            }
+            return;
+        }
+        if(partType != type)
+            return;
+        if(!started)
+        {
+            batch.addFeature(type);
+            started = true;
+        }
+        switch(type)
+        {
+            case PackedGeometry::PointFeature:
+            {
+                OGRPoint *op = static_cast<OGRPoint*>(geometry);
+                batch.addRing();
+                batch.addCoordinate(op->getX(),op->getY());
+                break;
+            }
+            case PackedGeometry::LineStringFeature:
+                readCurve(static_cast<OGRSimpleCurve*>(geometry),batch);
+                break;
+            case PackedGeometry::PolygonFeature:
+            {
+                OGRPolygon *op = static_cast<OGRPolygon*>(geometry);
+                readCurve(op->getExteriorRing(),batch);
+                for(int ringNum = 0; ringNum < op->getNumInteriorRings(); ringNum++)
+                    readCurve(op->getInteriorRing(ringNum),batch,true);
+                break;
+            }
+        }
+    }
+
+    // Adds one feature per geometry type present, with all parts of that type
+    // sharing the feature. Returns false if nothing could be read.
+    bool readGeometry(OGRGeometry *geometry, PackedGeometry &batch)
+    {
+        bool ret = false;
+        PackedGeometry::FeatureType types[] = {PackedGeometry::PolygonFeature,PackedGeometry::LineStringFeature,PackedGeometry::PointFeature};
+        for(auto type: types)
+        {
+            bool started = false;
+            readParts(geometry,type,batch,started);
+            ret = ret || started;
+        }
+        return ret;
+    }
+}
+
+VectorDatasetLoader::VectorDatasetLoader(GDALDataset* dataset, int batchSize):m_dataset(dataset),m_batchSize(batchSize),m_cancelled(false),m_featureCount(0),m_featuresRead(0),m_writeCache(false)
+{
+    qRegisterMetaType<PackedGeometry>();
+}
+
+VectorDatasetLoader::~VectorDatasetLoader()
+{
+    if(m_dataset)
+        GDALClose(m_dataset);
+}
+
+void VectorDatasetLoader::cancel()
+{
+    m_cancelled = true;
+}
+
+void VectorDatasetLoader::setAreaOfInterest(QGeoRectangle const &area)
+{
+    m_area = area;
+}
+
+void VectorDatasetLoader::setCachePath(QString const &path)
+{
+    m_cachePath = path;
+}
+
+bool VectorDatasetLoader::readCache()
+{
+    std::vector<VectorCache::Layer> layers;
+    if(m_cachePath.isEmpty() || !VectorCache::read(m_cachePath,layers,m_area))
+        return false;
+    for(auto const &layer: layers)
+        m_featureCount += layer.features.featureCount();
+    for(std::size_t i = 0; i < layers.size() && !m_cancelled; i++)
+    {
+        emit layerStarted(i,layers[i].name);
+        if(layers[i].features.featureCount() > 0)
+            emit batchReady(i,layers[i].features);
+        m_featuresRead += layers[i].features.featureCount();
+        emit progress(m_featuresRead,m_featureCount);
+    }
+    return true;
+}
+
+void VectorDatasetLoader::run()
+{
+    m_featureCount = 0;
+    m_featuresRead = 0;
+    if(readCache())
+    {
+        GDALClose(m_dataset);
+        m_dataset = nullptr;
+        emit finished();
+        return;
+    }
+
+    // a filtered read is incomplete, so only whole datasets are cached
+    m_writeCache = !m_cachePath.isEmpty() && !m_area.isValid();
+    m_cacheLayers.clear();
+    for(int i = 0; i < m_dataset->GetLayerCount(); ++i)
+    {
+        OGRLayer *layer = m_dataset->GetLayer(i);
+        applyAreaOfInterest(layer);
+        ignoreAttributes(layer);
+        m_featureCount += std::max<GIntBig>(0,layer->GetFeatureCount(FALSE));
+    }
+
+    for(int i = 0; i < m_dataset->GetLayerCount() && !m_cancelled; ++i)
+    {
+        OGRLayer *layer = m_dataset->GetLayer(i);
+        OGRCoordinateTransformation *unprojectTransformation = nullptr;
+        OGRSpatialReference *projected = layer->GetSpatialRef();
+        if(projected)
+        {
+            OGRSpatialReference wgs84;
+            setWGS84(wgs84);
+            unprojectTransformation = OGRCreateCoordinateTransformation(projected,&wgs84);
+        }
+
+        emit layerStarted(i,layer->GetName());
+        if(m_writeCache)
+        {
+            VectorCache::Layer cacheLayer;
+            cacheLayer.name = layer->GetName();
+            m_cacheLayers.push_back(cacheLayer);
+        }
+        layer->ResetReading();
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+        if(!readArrowBatches(i,layer,unprojectTransformation))
+#endif
+            readFeatures(i,layer,unprojectTransformation);
+        emit progress(m_featuresRead,m_featureCount);
+        if(unprojectTransformation)
+            OGRCoordinateTransformation::DestroyCT(unprojectTransformation);
+    }
+    GDALClose(m_dataset);
+    m_dataset = nullptr;
+    if(m_writeCache && !m_cancelled)
+        VectorCache::write(m_cachePath,m_cacheLayers);
+    m_cacheLayers.clear();
+    emit finished();
+}
+
+void VectorDatasetLoader::applyAreaOfInterest(OGRLayer* layer)
+{
+    if(!m_area.isValid())
+        return;
+
+    // sample the edges so the filter still covers the area after projection
+    const int steps = 8;
+    std::vector<double> x, y;
+    double west = m_area.topLeft().longitude();
+    double east = m_area.bottomRight().longitude();
+    double north = m_area.topLeft().latitude();
+    double south = m_area.bottomRight().latitude();
+    for(int i = 0; i <= steps; i++)
+    {
+        double u = i/double(steps);
+        double longitude = west+(east-west)*u;
+        double latitude = south+(north-south)*u;
+        x.push_back(longitude); y.push_back(south);
+        x.push_back(longitude); y.push_back(north);
+        x.push_back(west); y.push_back(latitude);
+        x.push_back(east); y.push_back(latitude);
+    }
+
+    OGRSpatialReference *projected = layer->GetSpatialRef();
+    if(projected)
+    {
+        OGRSpatialReference wgs84;
+        setWGS84(wgs84);
+        OGRCoordinateTransformation *projectTransformation = OGRCreateCoordinateTransformation(&wgs84,projected);
+        if(!projectTransformation)
+            return;
+        bool ok = projectTransformation->Transform(x.size(),x.data(),y.data());
+        OGRCoordinateTransformation::DestroyCT(projectTransformation);
+        if(!ok)
+            return;
+    }
+    layer->SetSpatialFilterRect(*std::min_element(x.begin(),x.end()),*std::min_element(y.begin(),y.end()),
+                                *std::max_element(x.begin(),x.end()),*std::max_element(y.begin(),y.end()));
+}
+
+void VectorDatasetLoader::ignoreAttributes(OGRLayer* layer)
+{
+    // only geometry is used, so spare the driver from decoding the rest
+    OGRFeatureDefn *definition = layer->GetLayerDefn();
+    std::vector<const char *> ignored;
+    for(int i = 0; i < definition->GetFieldCount(); i++)
+        ignored.push_back(definition->GetFieldDefn(i)->GetNameRef());
+    ignored.push_back("OGR_STYLE");
+    ignored.push_back(nullptr);
+    layer->SetIgnoredFields(ignored.data());
+}
+
+void VectorDatasetLoader::addGeometry(OGRGeometry* geometry, OGRCoordinateTransformation* transformation, PackedGeometry& batch)
+{
+    if(transformation)
+        geometry->transform(transformation);
+    // arcs are approximated by line segments
+    OGRGeometry *linear = nullptr;
+    if(geometry->hasCurveGeometry())
+        linear = geometry->getLinearGeometry();
+    if(!readGeometry(linear ? linear : geometry,batch) && !geometry->IsEmpty())
+        qDebug() << "type: " << geometry->getGeometryName();
+    if(linear)
+        OGRGeometryFactory::destroyGeometry(linear);
+}
+
+void VectorDatasetLoader::featureDone(int layer, PackedGeometry& batch)
+{
+    m_featuresRead++;
+    if(batch.featureCount() >= m_batchSize)
+    {
+        emitBatch(layer,batch);
+        emit progress(m_featuresRead,m_featureCount);
+        batch.clear();
+    }
+}
+
+void VectorDatasetLoader::emitBatch(int layer, PackedGeometry const &batch)
+{
+    if(m_writeCache)
+        m_cacheLayers[layer].features.append(batch);
+    emit batchReady(layer,batch);
+}
+
+void VectorDatasetLoader::readFeatures(int layerIndex, OGRLayer* layer, OGRCoordinateTransformation* transformation)
+{
+    PackedGeometry batch;
+    OGRFeature * feature = layer->GetNextFeature();
+    while(feature && !m_cancelled)
+    {
+        OGRGeometry * geometry = feature->GetGeometryRef();
+        if(geometry)
+            addGeometry(geometry,transformation,batch);
+        OGRFeature::DestroyFeature(feature);
+        featureDone(layerIndex,batch);
+        feature = layer->GetNextFeature();
+    }
+    if(feature)
+        OGRFeature::DestroyFeature(feature);
+    if(batch.featureCount() > 0)
+        emitBatch(layerIndex,batch);
+}
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+bool VectorDatasetLoader::readArrowBatches(int layerIndex, OGRLayer* layer, OGRCoordinateTransformation* transformation)
+{
+    // the generic stream is built on GetNextFeature and gains nothing
+    if(!layer->TestCapability(OLCFastGetArrowStream))
+        return false;
+
+    CPLStringList options;
+    options.SetNameValue("INCLUDE_FID","NO");
+    options.SetNameValue("MAX_FEATURES_IN_BATCH",QByteArray::number(m_batchSize).constData());
+    ArrowArrayStream stream;
+    if(!layer->GetArrowStream(&stream,options.List()))
+        return false;
+
+    ArrowSchema schema;
+    if(stream.get_schema(&stream,&schema) != 0)
+    {
+        stream.release(&stream);
+        return false;
+    }
+    QByteArray geometryName = layer->GetGeometryColumn();
+    if(geometryName.isEmpty())
+        geometryName = "wkb_geometry";
+    int geometryField = -1;
+    bool largeOffsets = false;
+    for(int64_t i = 0; i < schema.n_children; i++)
+        if(geometryName == schema.children[i]->name)
+        {
+            geometryField = i;
+            largeOffsets = QByteArray(schema.children[i]->format) == "Z";
+        }
+    schema.release(&schema);
+    if(geometryField < 0)
+    {
+        stream.release(&stream);
+        return false;
+    }
+
+    // WKB geometries come in a binary column: validity bitmap, offsets, data
+    PackedGeometry batch;
+    ArrowArray array;
+    while(!m_cancelled && stream.get_next(&stream,&array) == 0 && array.release)
+    {
+        ArrowArray const *column = array.children[geometryField];
+        uint8_t const *validity = static_cast<uint8_t const*>(column->buffers[0]);
+        uint8_t const *data = static_cast<uint8_t const*>(column->buffers[2]);
+        for(int64_t row = 0; row < column->length; row++)
+        {
+            int64_t i = row+column->offset;
+            if(!validity || (validity[i/8] & (1 << (i%8))))
+            {
+                int64_t begin, end;
+                if(largeOffsets)
+                {
+                    int64_t const *offsets = static_cast<int64_t const*>(column->buffers[1]);
+                    begin = offsets[i];
+                    end = offsets[i+1];
+                }
+                else
+                {
+                    int32_t const *offsets = static_cast<int32_t const*>(column->buffers[1]);
+                    begin = offsets[i];
+                    end = offsets[i+1];
+                }
+                OGRGeometry *geometry = nullptr;
+                if(OGRGeometryFactory::createFromWkb(data+begin,nullptr,&geometry,end-begin,wkbVariantIso) == OGRERR_NONE && geometry)
+                {
+                    addGeometry(geometry,transformation,batch);
+                    OGRGeometryFactory::destroyGeometry(geometry);
+                }
+            }
+            featureDone(layerIndex,batch);
+        }
+        array.release(&array);
+    }
+    stream.release(&stream);
+    if(batch.featureCount() > 0)
+        emitBatch(layerIndex,batch);
+    return true;
+}
+#endif
@@ -0,0 +1,67 @@
+#ifndef VECTORDATASETLOADER_H
+#define VECTORDATASETLOADER_H
+
+#include <QObject>
+#include <QGeoRectangle>
+#include <atomic>
+#include "packedgeometry.h"
+#include "vectorcache.h"
+
+class GDALDataset;
+class OGRLayer;
+class OGRGeometry;
+class OGRCoordinateTransformation;
+
+/// Reads the features of a vector dataset on a worker thread and hands them
+/// back, unprojected to WGS84, in packed batches through queued signals.
+class VectorDatasetLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Takes ownership of dataset, which must not be used elsewhere while loading.
+    VectorDatasetLoader(GDALDataset *dataset, int batchSize = 1000);
+    ~VectorDatasetLoader();
+
+    /// Only reads features whose bounding boxes overlap area. Arrow batches are
+    /// used where the driver streams them natively. Call before run.
+    void setAreaOfInterest(QGeoRectangle const &area);
+
+    /// Reads from the cache file when it is valid. Otherwise the dataset is
+    /// read and, if the whole of it was, the cache is written. Call before run.
+    void setCachePath(QString const &path);
+
+    /// Safe to call from any thread.
+    void cancel();
+
+signals:
+    void layerStarted(int layer, QString const &name);
+    void batchReady(int layer, PackedGeometry const &features);
+    void progress(qint64 featuresRead, qint64 featureCount);
+    void finished();
+
+public slots:
+    void run();
+
+private:
+    GDALDataset *m_dataset;
+    int m_batchSize;
+    std::atomic<bool> m_cancelled;
+    QGeoRectangle m_area;
+    qint64 m_featureCount;
+    qint64 m_featuresRead;
+    QString m_cachePath;
+    std::vector<VectorCache::Layer> m_cacheLayers;
+    bool m_writeCache;
+
+    bool readCache();
+    void applyAreaOfInterest(OGRLayer *layer);
+    void ignoreAttributes(OGRLayer *layer);
+    void addGeometry(OGRGeometry *geometry, OGRCoordinateTransformation *transformation, PackedGeometry &batch);
+    void featureDone(int layer, PackedGeometry &batch);
+    void emitBatch(int layer, PackedGeometry const &batch);
+    void readFeatures(int layerIndex, OGRLayer *layer, OGRCoordinateTransformation *transformation);
+    bool readArrowBatches(int layerIndex, OGRLayer *layer, OGRCoordinateTransformation *transformation);
+};
+
+#endif // VECTORDATASETLOADER_H
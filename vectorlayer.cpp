@@ -0,0 +1,535 @@
+#include "vectorlayer.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QGraphicsSceneMouseEvent>
+#include <QtMath>
+#include <limits>
+#include "autonomousvehicleproject.h"
+#include "backgroundraster.h"
+#include "point.h"
+#include "linestring.h"
+#include "polygon.h"
+#include "group.h"
+#include "symbolatlas.h"
+
+namespace
+{
+    // QRectF::intersects ignores empty rectangles, which single points are.
+    bool overlaps(QRectF const &a, QRectF const &b)
+    {
+        return a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom();
+    }
+
+    QPointF closestPoint(QPointF const &p, QPointF const &a, QPointF const &b)
+    {
+        QPointF ab = b-a;
+        QPointF ap = p-a;
+        qreal length2 = ab.x()*ab.x()+ab.y()*ab.y();
+        qreal t = 0.0;
+        if(length2 > 0.0)
+            t = std::max(0.0,std::min(1.0,(ap.x()*ab.x()+ap.y()*ab.y())/length2));
+        return a+ab*t;
+    }
+
+    qreal pointDistance(QPointF const &a, QPointF const &b)
+    {
+        QPointF d = b-a;
+        return qSqrt(d.x()*d.x()+d.y()*d.y());
+    }
+
+    qreal segmentDistance(QPointF const &p, QPointF const &a, QPointF const &b)
+    {
+        return pointDistance(p,closestPoint(p,a,b));
+    }
+
+    qreal cross(QPointF const &o, QPointF const &a, QPointF const &b)
+    {
+        return (a.x()-o.x())*(b.y()-o.y())-(a.y()-o.y())*(b.x()-o.x());
+    }
+
+    bool segmentsIntersect(QPointF const &a, QPointF const &b, QPointF const &c, QPointF const &d)
+    {
+        qreal d1 = cross(c,d,a);
+        qreal d2 = cross(c,d,b);
+        qreal d3 = cross(a,b,c);
+        qreal d4 = cross(a,b,d);
+        if(((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0)))
+            return true;
+        // touching or collinear cases
+        return (d1 == 0 && segmentDistance(a,c,d) == 0) || (d2 == 0 && segmentDistance(b,c,d) == 0) ||
+               (d3 == 0 && segmentDistance(c,a,b) == 0) || (d4 == 0 && segmentDistance(d,a,b) == 0);
+    }
+
+    bool polygonContains(QPolygonF const &polygon, QPointF const &point)
+    {
+        bool inside = false;
+        int n = polygon.size();
+        for(int i = 0, j = n-1; i < n; j = i++)
+            if((polygon[i].y() > point.y()) != (polygon[j].y() > point.y()) &&
+                point.x() < polygon[j].x()+(polygon[i].x()-polygon[j].x())*(point.y()-polygon[j].y())/(polygon[i].y()-polygon[j].y()))
+                inside = !inside;
+        return inside;
+    }
+}
+
+VectorLayer::VectorLayer(MissionItem* parent):GeoGraphicsMissionItem(parent),m_indexedCount(0),m_snapIndexed(false)
+{
+    setFlag(QGraphicsItem::ItemIsMovable, false);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptHoverEvents(false);
+}
+
+QRectF VectorLayer::boundingRect() const
+{
+    return m_bbox;
+}
+
+void VectorLayer::write(QJsonObject& json) const
+{
+}
+
+void VectorLayer::writeToMissionPlan(QJsonArray& navArray) const
+{
+}
+
+void VectorLayer::read(const QJsonObject& json)
+{
+}
+
+PackedGeometry const &VectorLayer::features() const
+{
+    return m_features;
+}
+
+void VectorLayer::addFeatures(PackedGeometry const &features)
+{
+    prepareGeometryChange();
+    int first = m_features.featureCount();
+    m_features.append(features);
+    projectFeatures(first);
+}
+
+void VectorLayer::updateProjectedPoints()
+{
+    prepareGeometryChange();
+    projectFeatures(0);
+    if(m_indexedCount > 0)
+        buildIndex();
+}
+
+void VectorLayer::buildIndex()
+{
+    m_index.build(m_featureBounds);
+    m_indexedCount = m_featureBounds.size();
+
+    std::vector<int> ringOffsets;
+    int ringCount = m_features.firstRing(m_features.featureCount());
+    ringOffsets.reserve(ringCount+1);
+    for(int r = 0; r <= ringCount; r++)
+        ringOffsets.push_back(m_features.firstCoordinate(r));
+    m_pyramid.build(m_pixels.data(),ringOffsets);
+}
+
+std::vector<int> VectorLayer::featuresInRect(QRectF const &rect) const
+{
+    std::vector<int> ret = m_index.query(rect);
+    for(int f = m_indexedCount; f < m_features.featureCount(); f++)
+        if(overlaps(m_featureBounds[f],rect))
+            ret.push_back(f);
+    return ret;
+}
+
+bool VectorLayer::crossesFeature(int feature, QPointF const &a, QPointF const &b) const
+{
+    for(int r = m_features.firstRing(feature); r < m_features.firstRing(feature)+m_features.ringCount(feature); r++)
+    {
+        int begin = m_features.firstCoordinate(r);
+        int end = m_features.firstCoordinate(r+1);
+        for(int i = begin+1; i < end; i++)
+            if(segmentsIntersect(a,b,m_pixels[i-1],m_pixels[i]))
+                return true;
+        // closing edge
+        if(m_features.featureType(feature) == PackedGeometry::PolygonFeature && end-begin > 2 && segmentsIntersect(a,b,m_pixels[end-1],m_pixels[begin]))
+            return true;
+    }
+    return false;
+}
+
+bool VectorLayer::featureContains(int feature, QPointF const &point) const
+{
+    if(m_features.featureType(feature) != PackedGeometry::PolygonFeature)
+        return false;
+    bool inside = false;
+    for(int r = m_features.firstRing(feature); r < m_features.firstRing(feature)+m_features.ringCount(feature); r++)
+    {
+        QPolygonF ring;
+        for(int i = m_features.firstCoordinate(r); i < m_features.firstCoordinate(r+1); i++)
+            ring << m_pixels[i];
+        if(polygonContains(ring,point))
+            inside = !inside;
+    }
+    return inside;
+}
+
+std::vector<int> VectorLayer::featuresCrossingLine(QPolygonF const &line, qreal tolerance) const
+{
+    std::vector<int> ret;
+    if(line.empty())
+        return ret;
+    QRectF bounds = line.boundingRect().adjusted(-tolerance,-tolerance,tolerance,tolerance);
+    for(int f: featuresInRect(bounds))
+    {
+        bool hit = false;
+        if(m_features.featureType(f) == PackedGeometry::PointFeature)
+        {
+            QPointF const &p = m_pixels[m_features.firstCoordinate(m_features.firstRing(f))];
+            for(int i = 0; i+1 < line.size() && !hit; i++)
+                hit = segmentDistance(p,line[i],line[i+1]) <= tolerance;
+        }
+        else
+        {
+            hit = featureContains(f,line.front());
+            for(int i = 0; i+1 < line.size() && !hit; i++)
+                hit = overlaps(m_featureBounds[f],QRectF(line[i],line[i+1]).normalized()) && crossesFeature(f,line[i],line[i+1]);
+        }
+        if(hit)
+            ret.push_back(f);
+    }
+    return ret;
+}
+
+std::vector<int> VectorLayer::featuresInPolygon(QPolygonF const &polygon) const
+{
+    std::vector<int> ret;
+    if(polygon.size() < 3)
+        return ret;
+    for(int f: featuresInRect(polygon.boundingRect()))
+    {
+        // a vertex inside, an edge crossing, or the query inside a polygon feature
+        QPointF const &first = m_pixels[m_features.firstCoordinate(m_features.firstRing(f))];
+        bool hit = polygonContains(polygon,first) || featureContains(f,polygon.front());
+        for(int i = 0, n = polygon.size(); i < n && !hit; i++)
+            hit = crossesFeature(f,polygon[i],polygon[(i+1)%n]);
+        if(hit)
+            ret.push_back(f);
+    }
+    return ret;
+}
+
+void VectorLayer::projectFeatures(int firstFeature)
+{
+    AutonomousVehicleProject *project = autonomousVehicleProject();
+    int firstCoordinate = m_features.coordinateCount();
+    if(firstFeature < m_features.featureCount())
+        firstCoordinate = m_features.firstCoordinate(m_features.firstRing(firstFeature));
+    m_pixels.resize(m_features.coordinateCount());
+    m_snapIndexed = false;
+    for(int i = firstCoordinate; i < m_features.coordinateCount(); i++)
+    {
+        QPointF const &c = m_features.coordinate(i);
+        m_pixels[i] = geoToPixel(QGeoCoordinate(c.y(),c.x()),project);
+    }
+
+    m_featureBounds.resize(m_features.featureCount());
+    // Points have null rects, which QRectF::united() skips, so the layer's
+    // bounds are accumulated by hand. Earlier features only count when they
+    // have vertices.
+    bool haveBounds = firstCoordinate > 0;
+    qreal bboxLeft = m_bbox.left();
+    qreal bboxRight = m_bbox.right();
+    qreal bboxTop = m_bbox.top();
+    qreal bboxBottom = m_bbox.bottom();
+    for(int f = firstFeature; f < m_features.featureCount(); f++)
+    {
+        int firstRing = m_features.firstRing(f);
+        int begin = m_features.firstCoordinate(firstRing);
+        int end = m_features.firstCoordinate(firstRing+m_features.ringCount(f));
+        if(begin == end)
+        {
+            m_featureBounds[f] = QRectF();
+            continue;
+        }
+        qreal left = m_pixels[begin].x();
+        qreal right = left;
+        qreal top = m_pixels[begin].y();
+        qreal bottom = top;
+        for(int i = begin+1; i < end; i++)
+        {
+            left = std::min(left,m_pixels[i].x());
+            right = std::max(right,m_pixels[i].x());
+            top = std::min(top,m_pixels[i].y());
+            bottom = std::max(bottom,m_pixels[i].y());
+        }
+        m_featureBounds[f] = QRectF(QPointF(left,top),QPointF(right,bottom));
+        if(!haveBounds)
+        {
+            bboxLeft = left;
+            bboxRight = right;
+            bboxTop = top;
+            bboxBottom = bottom;
+            haveBounds = true;
+        }
+        bboxLeft = std::min(bboxLeft,left);
+        bboxRight = std::max(bboxRight,right);
+        bboxTop = std::min(bboxTop,top);
+        bboxBottom = std::max(bboxBottom,bottom);
+    }
+    if(haveBounds)
+        m_bbox = QRectF(QPointF(bboxLeft,bboxTop),QPointF(bboxRight,bboxBottom));
+    else
+        m_bbox = QRectF();
+}
+
+void VectorLayer::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    // size of a screen pixel in item coordinates
+    QTransform t = painter->worldTransform();
+    qreal pixel = 1.0/std::max(1e-9,qSqrt(t.m11()*t.m11()+t.m12()*t.m12()));
+    SymbolAtlas *atlas = autonomousVehicleProject()->symbolAtlas();
+    QSizeF symbol = atlas->symbolSize("Square");
+    qreal margin = std::max(5.0,std::max(symbol.width(),symbol.height())/2.0)*pixel;
+    QRectF exposed = option->exposedRect.adjusted(-margin,-margin,margin,margin);
+
+    std::vector<int> visible = featuresInRect(exposed);
+
+    int level = m_pyramid.levelFor(t);
+    auto ring = [this,level](int r, QPointF const *&points, int &count)
+    {
+        if(level >= 0 && r < m_pyramid.ringCount())
+        {
+            points = m_pyramid.ring(level,r);
+            count = m_pyramid.ringSize(level,r);
+        }
+        else
+        {
+            points = &m_pixels[m_features.firstCoordinate(r)];
+            count = m_features.coordinateCount(r);
+        }
+    };
+    QPointF const *points;
+    int count;
+
+    painter->save();
+    QPen p;
+    p.setCosmetic(true);
+    painter->setBrush(Qt::NoBrush);
+
+    p.setColor(Qt::blue);
+    p.setWidth(2);
+    painter->setPen(p);
+    for(int f: visible)
+        if(m_features.featureType(f) == PackedGeometry::PolygonFeature)
+            for(int r = m_features.firstRing(f); r < m_features.firstRing(f)+m_features.ringCount(f); r++)
+            {
+                ring(r,points,count);
+                if(count > 1)
+                    painter->drawPolygon(points,count);
+            }
+
+    p.setColor(Qt::red);
+    p.setWidth(3);
+    painter->setPen(p);
+    for(int f: visible)
+        if(m_features.featureType(f) == PackedGeometry::LineStringFeature)
+            for(int r = m_features.firstRing(f); r < m_features.firstRing(f)+m_features.ringCount(f); r++)
+            {
+                ring(r,points,count);
+                if(count > 1)
+                    painter->drawPolyline(points,count);
+            }
+
+    std::vector<QPointF> symbols;
+    for(int f: visible)
+        if(m_features.featureType(f) == PackedGeometry::PointFeature)
+            for(int r = m_features.firstRing(f); r < m_features.firstRing(f)+m_features.ringCount(f); r++)
+                for(int i = m_features.firstCoordinate(r); i < m_features.firstCoordinate(r+1); i++)
+                    symbols.push_back(m_pixels[i]);
+    atlas->draw(painter,"Square",symbols.data(),symbols.size());
+
+    painter->restore();
+}
+
+void VectorLayer::buildSnapIndex()
+{
+    m_snapSegments.clear();
+    std::vector<QRectF> boxes;
+    boxes.reserve(m_pixels.size());
+    m_snapSegments.reserve(m_pixels.size());
+    for(int f = 0; f < m_features.featureCount(); f++)
+        for(int r = m_features.firstRing(f); r < m_features.firstRing(f)+m_features.ringCount(f); r++)
+        {
+            int begin = m_features.firstCoordinate(r);
+            int end = m_features.firstCoordinate(r+1);
+            if(end-begin == 1)
+                m_snapSegments.push_back(std::make_pair(begin,begin));
+            for(int i = begin+1; i < end; i++)
+                m_snapSegments.push_back(std::make_pair(i-1,i));
+            if(m_features.featureType(f) == PackedGeometry::PolygonFeature && end-begin > 2 && m_pixels[begin] != m_pixels[end-1])
+                m_snapSegments.push_back(std::make_pair(end-1,begin));
+        }
+    for(auto const &s: m_snapSegments)
+        boxes.push_back(QRectF(m_pixels[s.first],m_pixels[s.second]));
+    m_snapIndex.build(boxes);
+    m_snapIndexed = true;
+}
+
+bool VectorLayer::snap(const QPointF& position, qreal tolerance, QPointF& snapped)
+{
+    if(!m_snapIndexed)
+        buildSnapIndex();
+    auto segmentAt = [this,&position](int s){return segmentDistance(position,m_pixels[m_snapSegments[s].first],m_pixels[m_snapSegments[s].second]);};
+    std::vector<int> candidates = m_snapIndex.nearest(position,8,tolerance,segmentAt);
+    if(candidates.empty())
+        return false;
+
+    // vertices win over edges so lines can be joined end to end
+    qreal best = tolerance;
+    bool found = false;
+    for(int s: candidates)
+        for(int v: {m_snapSegments[s].first,m_snapSegments[s].second})
+        {
+            qreal d = pointDistance(position,m_pixels[v]);
+            if(d <= best)
+            {
+                best = d;
+                snapped = m_pixels[v];
+                found = true;
+            }
+        }
+    if(!found)
+        snapped = closestPoint(position,m_pixels[m_snapSegments[candidates.front()].first],m_pixels[m_snapSegments[candidates.front()].second]);
+    return true;
+}
+
+qreal VectorLayer::pickTolerance() const
+{
+    qreal scale = 1.0;
+    auto bgr = autonomousVehicleProject()->getBackgroundRaster();
+    if(bgr)
+        scale = 1.0/bgr->mapScale();
+    return 5*scale;
+}
+
+bool VectorLayer::contains(const QPointF& point) const
+{
+    return featureAt(point,pickTolerance()) >= 0;
+}
+
+int VectorLayer::featureAt(const QPointF& position, qreal tolerance) const
+{
+    QRectF probe(position.x()-tolerance,position.y()-tolerance,2*tolerance,2*tolerance);
+    int ret = -1;
+    qreal best = std::numeric_limits<qreal>::max();
+    for(int f: featuresInRect(probe))
+    {
+        qreal distance = std::numeric_limits<qreal>::max();
+        bool inside = false;
+        for(int r = m_features.firstRing(f); r < m_features.firstRing(f)+m_features.ringCount(f); r++)
+        {
+            int begin = m_features.firstCoordinate(r);
+            int end = m_features.firstCoordinate(r+1);
+            if(end-begin == 1)
+                distance = std::min(distance,segmentDistance(position,m_pixels[begin],m_pixels[begin]));
+            for(int i = begin+1; i < end; i++)
+                distance = std::min(distance,segmentDistance(position,m_pixels[i-1],m_pixels[i]));
+            if(m_features.featureType(f) == PackedGeometry::PolygonFeature)
+            {
+                // even-odd over all rings handles holes
+                for(int i = begin, j = end-1; i < end; j = i++)
+                    if((m_pixels[i].y() > position.y()) != (m_pixels[j].y() > position.y()) &&
+                        position.x() < m_pixels[j].x()+(m_pixels[i].x()-m_pixels[j].x())*(position.y()-m_pixels[j].y())/(m_pixels[i].y()-m_pixels[j].y()))
+                        inside = !inside;
+            }
+        }
+        // an interior hit ranks behind anything drawn close by
+        if(inside)
+            distance = std::min(distance,tolerance);
+        if(distance <= tolerance && distance < best)
+        {
+            best = distance;
+            ret = f;
+        }
+    }
+    return ret;
+}
+
+MissionItem * VectorLayer::materializeFeature(int feature)
+{
+    if(feature < 0 || feature >= m_features.featureCount())
+        return nullptr;
+    if(m_materialized.contains(feature) && m_materialized[feature])
+        return m_materialized[feature];
+
+    // multi-part features become a group holding one item per part
+    MissionItem *ret = nullptr;
+    MissionItem *parent = this;
+    if(m_features.partCount(feature) > 1)
+    {
+        const char *names[] = {"multiPoint","multiLineString","multiPolygon"};
+        ret = parent = createMissionItem<Group>(names[m_features.featureType(feature)]);
+    }
+
+    int firstRing = m_features.firstRing(feature);
+    auto location = [this](int i){QPointF const &c = m_features.coordinate(i); return QGeoCoordinate(c.y(),c.x());};
+    Polygon *polygon = nullptr;
+    for(int r = firstRing; r < firstRing+m_features.ringCount(feature); r++)
+    {
+        MissionItem *part = nullptr;
+        switch(m_features.featureType(feature))
+        {
+            case PackedGeometry::PointFeature:
+            {
+                Point *p = parent->createMissionItem<Point>("point");
+                p->setLocation(location(m_features.firstCoordinate(r)));
+                part = p;
+                break;
+            }
+            case PackedGeometry::LineStringFeature:
+            {
+                LineString *ls = parent->createMissionItem<LineString>("lineString");
+                for(int i = m_features.firstCoordinate(r); i < m_features.firstCoordinate(r+1); i++)
+                    ls->addPoint(location(i));
+                part = ls;
+                break;
+            }
+            case PackedGeometry::PolygonFeature:
+            {
+                if(m_features.isHole(r) && polygon)
+                {
+                    polygon->addInteriorRing();
+                    for(int i = m_features.firstCoordinate(r); i < m_features.firstCoordinate(r+1); i++)
+                        polygon->addInteriorPoint(location(i));
+                }
+                else
+                {
+                    if(polygon)
+                        polygon->updateBBox();
+                    polygon = parent->createMissionItem<Polygon>("polygon");
+                    for(int i = m_features.firstCoordinate(r); i < m_features.firstCoordinate(r+1); i++)
+                        polygon->addExteriorPoint(location(i));
+                    connect(autonomousVehicleProject(),&AutonomousVehicleProject::backgroundUpdated,polygon,&Polygon::updateBackground);
+                    part = polygon;
+                }
+                break;
+            }
+        }
+        if(!ret)
+            ret = part;
+    }
+    if(polygon)
+        polygon->updateBBox();
+    m_materialized[feature] = ret;
+    return ret;
+}
+
+void VectorLayer::mouseDoubleClickEvent(QGraphicsSceneMouseEvent* event)
+{
+    int feature = featureAt(event->pos(),pickTolerance());
+    if(feature >= 0)
+    {
+        materializeFeature(feature);
+        event->accept();
+    }
+    else
+        GeoGraphicsMissionItem::mouseDoubleClickEvent(event);
+}
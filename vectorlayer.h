@@ -0,0 +1,85 @@
+#ifndef VECTORLAYER_H
+#define VECTORLAYER_H
+
+#include "geographicsmissionitem.h"
+#include "packedgeometry.h"
+#include "rtree.h"
+#include "simplificationpyramid.h"
+#include <QPointer>
+#include <QMap>
+
+/// All features of one vector layer, drawn and hit-tested by a single graphics
+/// item. Features are kept packed and only become tree items on request.
+class VectorLayer : public GeoGraphicsMissionItem
+{
+    Q_OBJECT
+    Q_INTERFACES(QGraphicsItem)
+public:
+    explicit VectorLayer(MissionItem *parent = 0);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    bool contains(const QPointF &point) const override;
+
+    void write(QJsonObject &json) const override;
+    void writeToMissionPlan(QJsonArray & navArray) const override;
+    void read(const QJsonObject &json) override;
+
+    int type() const override {return VectorLayerType;}
+
+    void addFeatures(PackedGeometry const &features);
+    PackedGeometry const &features() const;
+
+    /// Index of the feature closest to position (item coordinates) within
+    /// tolerance, or -1.
+    int featureAt(QPointF const &position, qreal tolerance) const;
+
+    /// Features whose bounding boxes overlap rect.
+    std::vector<int> featuresInRect(QRectF const &rect) const;
+    /// Features crossed by the polyline, or containing it for polygons. Points
+    /// count if they are within tolerance of it.
+    std::vector<int> featuresCrossingLine(QPolygonF const &line, qreal tolerance = 0.0) const;
+    /// Features with any part inside polygon.
+    std::vector<int> featuresInPolygon(QPolygonF const &polygon) const;
+
+    /// Moves position (item coordinates) onto the nearest vertex within
+    /// tolerance, or else onto the nearest edge. Returns false if nothing is
+    /// that close. Snapping uses its own index over segments, built on first use.
+    bool snap(QPointF const &position, qreal tolerance, QPointF &snapped);
+
+    /// Bulk loads the spatial index and the simplification pyramid over all
+    /// features. Features added later are scanned linearly and drawn at full
+    /// resolution until the next build.
+    void buildIndex();
+
+    /// Returns the tree item for a feature, creating it on first use.
+    MissionItem * materializeFeature(int feature);
+
+public slots:
+    void updateProjectedPoints() override;
+
+protected:
+    void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) override;
+
+private:
+    PackedGeometry m_features;
+    std::vector<QPointF> m_pixels;
+    std::vector<QRectF> m_featureBounds;
+    QRectF m_bbox;
+    QMap<int, QPointer<MissionItem> > m_materialized;
+    RTree m_index;
+    int m_indexedCount;
+    SimplificationPyramid m_pyramid;
+    // segments and lone points as coordinate index pairs
+    std::vector<std::pair<int,int> > m_snapSegments;
+    RTree m_snapIndex;
+    bool m_snapIndexed;
+
+    void projectFeatures(int firstFeature);
+    void buildSnapIndex();
+    qreal pickTolerance() const;
+    bool crossesFeature(int feature, QPointF const &a, QPointF const &b) const;
+    bool featureContains(int feature, QPointF const &point) const;
+};
+
+#endif // VECTORLAYER_H
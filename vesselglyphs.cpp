@@ -0,0 +1,83 @@
+#include "vesselglyphs.h"
+#include <QtMath>
+
+namespace
+{
+    // about 5km of latitude, small enough for the frame to be taken as uniform
+    const double cellSize = 0.05;
+    const std::size_t maxOutlines = 4096;
+
+    QPointF metric(double distance, double azimuth)
+    {
+        return QPointF(distance*qSin(qDegreesToRadians(azimuth)),distance*qCos(qDegreesToRadians(azimuth)));
+    }
+}
+
+VesselGlyphs::VesselGlyphs(std::function<QPointF(QGeoCoordinate const &)> const &project):m_project(project)
+{
+    m_triangle.moveTo(metric(15,0));
+    m_triangle.lineTo(metric(15,-150));
+    m_triangle.lineTo(metric(15,150));
+    m_triangle.lineTo(metric(15,0));
+}
+
+void VesselGlyphs::clear()
+{
+    m_frames.clear();
+}
+
+VesselGlyphs::Frame const & VesselGlyphs::frame(const QGeoCoordinate& location)
+{
+    qint64 row = qFloor((location.latitude()+90.0)/cellSize);
+    qint64 column = qFloor((location.longitude()+180.0)/cellSize);
+    qint64 key = row*qint64(360.0/cellSize+1)+column;
+    auto f = m_frames.find(key);
+    if(f != m_frames.end())
+        return f->second;
+
+    QGeoCoordinate center((row+0.5)*cellSize-90.0,(column+0.5)*cellSize-180.0);
+    QPointF origin = m_project(center);
+    Frame ret;
+    ret.east = (m_project(center.atDistanceAndAzimuth(100.0,90.0))-origin)/100.0;
+    ret.north = (m_project(center.atDistanceAndAzimuth(100.0,0.0))-origin)/100.0;
+    return m_frames[key] = ret;
+}
+
+QTransform VesselGlyphs::placement(const QGeoCoordinate& location, double headingDegrees, double scale)
+{
+    Frame const &f = frame(location);
+    // rotate clockwise by the heading in the metric frame, then to pixels
+    double c = qCos(qDegreesToRadians(headingDegrees))*scale;
+    double s = qSin(qDegreesToRadians(headingDegrees))*scale;
+    QPointF x = f.east*c-f.north*s;
+    QPointF y = f.east*s+f.north*c;
+    QPointF p = m_project(location);
+    return QTransform(x.x(),x.y(),y.x(),y.y(),p.x(),p.y());
+}
+
+void VesselGlyphs::addTriangle(QPainterPath& path, const QGeoCoordinate& location, double headingDegrees, double scale)
+{
+    path.addPath(placement(location,headingDegrees,scale).map(m_triangle));
+}
+
+void VesselGlyphs::addShipOutline(QPainterPath& path, const QGeoCoordinate& location, double headingDegrees, float dimensionToBow, float dimensionToPort, float dimensionToStbd, float dimensionToStern)
+{
+    Dimensions key(dimensionToBow,dimensionToPort,dimensionToStbd,dimensionToStern);
+    auto o = m_outlines.find(key);
+    if(o == m_outlines.end())
+    {
+        if(m_outlines.size() >= maxOutlines)
+            m_outlines.clear();
+        float length = dimensionToBow+dimensionToStern;
+        float width = dimensionToPort+dimensionToStbd;
+        QPainterPath outline;
+        outline.moveTo(-dimensionToPort,-dimensionToStern);
+        outline.lineTo(dimensionToStbd,-dimensionToStern);
+        outline.lineTo(dimensionToStbd,-dimensionToStern+length*.8);
+        outline.lineTo(-dimensionToPort+width/2.0,dimensionToBow);
+        outline.lineTo(-dimensionToPort,-dimensionToStern+length*.8);
+        outline.lineTo(-dimensionToPort,-dimensionToStern);
+        o = m_outlines.insert(std::make_pair(key,outline)).first;
+    }
+    path.addPath(placement(location,headingDegrees,1.0).map(o->second));
+}
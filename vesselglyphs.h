@@ -0,0 +1,47 @@
+#ifndef VESSELGLYPHS_H
+#define VESSELGLYPHS_H
+
+#include <QGeoCoordinate>
+#include <QPainterPath>
+#include <QPointF>
+#include <QTransform>
+#include <functional>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+/// Vessel symbols built once in a local metric frame (x east, y north, in
+/// meters) and placed with an affine transform, instead of walking geodesics
+/// for every corner. The transform's linear part, meters to pixels around a
+/// location, is sampled once per grid cell and reused by every vessel in it.
+class VesselGlyphs
+{
+public:
+    /// project maps a geographic position to item pixels.
+    explicit VesselGlyphs(std::function<QPointF(QGeoCoordinate const &)> const &project);
+
+    /// Forgets the sampled frames after the projection changes.
+    void clear();
+
+    void addTriangle(QPainterPath &path, QGeoCoordinate const &location, double headingDegrees, double scale);
+    void addShipOutline(QPainterPath &path, QGeoCoordinate const &location, double headingDegrees, float dimensionToBow, float dimensionToPort, float dimensionToStbd, float dimensionToStern);
+
+private:
+    struct Frame
+    {
+        QPointF east;  // pixels per meter east
+        QPointF north; // pixels per meter north
+    };
+
+    typedef std::tuple<float,float,float,float> Dimensions;
+
+    std::function<QPointF(QGeoCoordinate const &)> m_project;
+    std::unordered_map<qint64, Frame> m_frames;
+    std::map<Dimensions, QPainterPath> m_outlines;
+    QPainterPath m_triangle;
+
+    Frame const &frame(QGeoCoordinate const &location);
+    QTransform placement(QGeoCoordinate const &location, double headingDegrees, double scale);
+};
+
+#endif // VESSELGLYPHS_H